@@ -38,6 +38,9 @@ set(VKB_VALIDATION_LAYERS OFF CACHE BOOL "Enable validation layers for every app
 set(VKB_VALIDATION_LAYERS_GPU_ASSISTED OFF CACHE BOOL "Enable GPU assisted validation layers for every application.")
 set(VKB_BUILD_SAMPLES ON CACHE BOOL "Enable generation and building of Vulkan best practice samples.")
 set(VKB_BUILD_TESTS OFF CACHE BOOL "Enable generation and building of Vulkan best practice tests.")
+set(VKB_OFFLINE_SHADERS OFF CACHE BOOL "Enable compilation of the shaders to SPIR-V at build time.")
+set(VKB_ALLOCATION_COUNTER OFF CACHE BOOL "Enable counting of the heap allocations, to check that recording draws does not allocate.")
+set(VKB_SPIRV_OPTIMIZER OFF CACHE BOOL "Enable optimization of the compiled SPIR-V with SPIRV-Tools.")
 set(VKB_WSI_SELECTION "XCB" CACHE STRING "Select WSI target (XCB, XLIB, WAYLAND, D2D)")
 
 set(CMAKE_RUNTIME_OUTPUT_DIRECTORY "bin/${CMAKE_BUILD_TYPE}/${TARGET_ARCH}")
@@ -25,31 +25,39 @@
 
 namespace vkb
 {
-BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
-    buffer{device, size, usage, memory_usage}
+namespace
+{
+VkDeviceSize get_allocation_alignment(Device &device, VkBufferUsageFlags usage)
 {
 	if (usage == VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
+		return device.get_gpu().get_properties().limits.minUniformBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_STORAGE_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
+		return device.get_gpu().get_properties().limits.minStorageBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_UNIFORM_TEXEL_BUFFER_BIT)
 	{
-		alignment = device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
+		return device.get_gpu().get_properties().limits.minTexelBufferOffsetAlignment;
 	}
 	else if (usage == VK_BUFFER_USAGE_INDEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_VERTEX_BUFFER_BIT || usage == VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT)
 	{
 		// Used to calculate the offset, required when allocating memory (its value should be power of 2)
-		alignment = 16;
+		return 16;
 	}
 	else
 	{
 		throw std::runtime_error("Usage not recognised");
 	}
 }
+}        // namespace
+
+BufferBlock::BufferBlock(Device &device, VkDeviceSize size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    buffer{device, size, usage, memory_usage},
+    alignment{get_allocation_alignment(device, usage)}
+{
+}
 
 BufferAllocation BufferBlock::allocate(const uint32_t allocate_size)
 {
@@ -120,6 +128,156 @@ void BufferPool::reset()
 	active_buffer_block_count = 0;
 }
 
+BufferRing::BufferRing(Device &device, VkDeviceSize initial_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage) :
+    device{device},
+    usage{usage},
+    memory_usage{memory_usage},
+    alignment{get_allocation_alignment(device, usage)},
+    size{initial_size}
+{
+	assert(initial_size > 0 && "Buffer ring size must be greater than zero");
+}
+
+BufferRing::~BufferRing()
+{
+	if (buffer)
+	{
+		LOGD("Buffer ring ({}) high-water mark: {} KB of {} KB", usage, high_water_mark / 1024, size / 1024);
+	}
+}
+
+void BufferRing::begin_frame(const RenderFrame &frame)
+{
+	for (auto &frame_range : frame_ranges)
+	{
+		if (frame_range.frame == &frame)
+		{
+			frame_range.released = true;
+		}
+	}
+
+	// The free space starts at the oldest frame still in flight
+	while (!frame_ranges.empty() && frame_ranges.front().released)
+	{
+		frame_ranges.pop_front();
+	}
+
+	frame_ranges.push_back({&frame, frame_sequence++, head, false});
+
+	auto oldest_sequence = frame_ranges.front().sequence;
+
+	retired_buffers.erase(std::remove_if(retired_buffers.begin(), retired_buffers.end(),
+	                                     [oldest_sequence](const RetiredBuffer &retired_buffer) { return retired_buffer.end_sequence <= oldest_sequence; }),
+	                      retired_buffers.end());
+}
+
+BufferAllocation BufferRing::allocate(const uint32_t allocate_size)
+{
+	assert(allocate_size > 0 && "Allocation size must be greater than zero");
+
+	if (!buffer)
+	{
+		grow(allocate_size);
+	}
+	else if (head == get_tail())
+	{
+		// Nothing is in use, allocate from the start of the buffer
+		restart();
+	}
+
+	VkDeviceSize offset{0};
+
+	if (!find_free_offset(allocate_size, offset))
+	{
+		grow(allocate_size);
+
+		offset = 0;
+	}
+
+	head = offset + allocate_size;
+
+	high_water_mark = std::max(high_water_mark, get_used_size());
+
+	return BufferAllocation{*buffer, allocate_size, offset};
+}
+
+VkDeviceSize BufferRing::get_size() const
+{
+	return size;
+}
+
+VkDeviceSize BufferRing::get_high_water_mark() const
+{
+	return high_water_mark;
+}
+
+void BufferRing::grow(VkDeviceSize minimum_size)
+{
+	if (buffer)
+	{
+		// The frames in flight and the current one may still use the previous buffer
+		retired_buffers.push_back({std::move(buffer), frame_sequence});
+
+		size *= 2;
+	}
+
+	while (size < minimum_size)
+	{
+		size *= 2;
+	}
+
+	LOGD("Building {} KB buffer ring ({})", size / 1024, usage);
+
+	buffer = std::make_unique<core::Buffer>(device, size, usage, memory_usage);
+
+	restart();
+}
+
+void BufferRing::restart()
+{
+	head = 0;
+
+	for (auto &frame_range : frame_ranges)
+	{
+		frame_range.begin = 0;
+	}
+}
+
+bool BufferRing::find_free_offset(uint32_t allocate_size, VkDeviceSize &offset) const
+{
+	auto tail           = get_tail();
+	auto aligned_offset = (head + alignment - 1) & ~(alignment - 1);
+
+	// Allocations never reach the tail, so that the ring is empty when the head and the tail are equal
+	if (head < tail)
+	{
+		offset = aligned_offset;
+		return aligned_offset + allocate_size < tail;
+	}
+
+	if (aligned_offset + allocate_size <= size)
+	{
+		offset = aligned_offset;
+		return true;
+	}
+
+	// Wrap around to the start of the buffer
+	offset = 0;
+	return allocate_size < tail;
+}
+
+VkDeviceSize BufferRing::get_tail() const
+{
+	return frame_ranges.empty() ? head : frame_ranges.front().begin;
+}
+
+VkDeviceSize BufferRing::get_used_size() const
+{
+	auto tail = get_tail();
+
+	return head >= tail ? head - tail : size - tail + head;
+}
+
 BufferAllocation::BufferAllocation(core::Buffer &buffer, VkDeviceSize size, VkDeviceSize offset) :
     buffer{&buffer},
     size{size},
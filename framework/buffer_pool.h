@@ -17,12 +17,15 @@
 
 #pragma once
 
+#include <deque>
+
 #include "common/helpers.h"
 #include "core/buffer.h"
 
 namespace vkb
 {
 class Device;
+class RenderFrame;
 
 /**
  * @brief An allocation of vulkan memory; different buffer allocations,
@@ -135,4 +138,121 @@ class BufferPool
 	/// Numbers of active blocks from the start of buffer_blocks
 	uint32_t active_buffer_block_count{0};
 };
+
+/**
+ * @brief A persistently mapped buffer for a specific usage, allocated as a ring by the frames in flight.
+ *
+ * Each frame allocates after the allocations of the previous one, wrapping around at the end of
+ * the buffer. The allocations of a frame are released when it begins again, once its fence
+ * was waited for. If there is not enough free space, a buffer twice as large replaces the ring,
+ * and the previous one is kept until the frames using it are complete.
+ *
+ * Allocations are only valid within a frame, between calls to begin_frame.
+ */
+class BufferRing
+{
+  public:
+	BufferRing(Device &device, VkDeviceSize initial_size, VkBufferUsageFlags usage, VmaMemoryUsage memory_usage = VMA_MEMORY_USAGE_CPU_TO_GPU);
+
+	BufferRing(const BufferRing &) = delete;
+
+	BufferRing(BufferRing &&) = delete;
+
+	~BufferRing();
+
+	BufferRing &operator=(const BufferRing &) = delete;
+
+	BufferRing &operator=(BufferRing &&) = delete;
+
+	/**
+	 * @brief Starts the allocations of a frame, releasing the ones it made since it last began
+	 * @param frame The frame, whose fence must have been waited for
+	 */
+	void begin_frame(const RenderFrame &frame);
+
+	/**
+	 * @return An usable view on a portion of the ring buffer
+	 */
+	BufferAllocation allocate(uint32_t size);
+
+	VkDeviceSize get_size() const;
+
+	/**
+	 * @return The largest amount of memory in use by the frames in flight since the ring was created
+	 */
+	VkDeviceSize get_high_water_mark() const;
+
+  private:
+	/// Start of the allocations of a frame in flight
+	struct FrameRange
+	{
+		const RenderFrame *frame;
+
+		uint64_t sequence;
+
+		VkDeviceSize begin;
+
+		bool released;
+	};
+
+	/// A buffer replaced by a larger one, with the sequence number of the first frame which does not use it
+	struct RetiredBuffer
+	{
+		std::unique_ptr<core::Buffer> buffer;
+
+		uint64_t end_sequence;
+	};
+
+	/**
+	 * @brief Replaces the ring buffer with a larger one that fits an allocation
+	 */
+	void grow(VkDeviceSize minimum_size);
+
+	/**
+	 * @brief Moves the next allocation to the start of the buffer, when nothing in it is in use
+	 */
+	void restart();
+
+	/**
+	 * @brief Finds where an allocation fits between the current offset and the oldest frame in flight
+	 * @return False if there is not enough free space
+	 */
+	bool find_free_offset(uint32_t allocate_size, VkDeviceSize &offset) const;
+
+	/**
+	 * @return The offset of the first allocation of the oldest frame in flight
+	 */
+	VkDeviceSize get_tail() const;
+
+	/**
+	 * @return The amount of memory from the oldest frame in flight to the current offset
+	 */
+	VkDeviceSize get_used_size() const;
+
+	Device &device;
+
+	VkBufferUsageFlags usage{};
+
+	VmaMemoryUsage memory_usage{};
+
+	/// Memory alignment of the allocations, according to the usage
+	VkDeviceSize alignment{0};
+
+	/// Size of the buffer, created on the first allocation
+	VkDeviceSize size{0};
+
+	std::unique_ptr<core::Buffer> buffer;
+
+	/// Offset of the next allocation
+	VkDeviceSize head{0};
+
+	/// Frames whose allocations may still be in use, oldest first
+	std::deque<FrameRange> frame_ranges;
+
+	uint64_t frame_sequence{0};
+
+	std::vector<RetiredBuffer> retired_buffers;
+
+	VkDeviceSize high_water_mark{0};
+};
 }        // namespace vkb
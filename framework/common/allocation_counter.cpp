@@ -0,0 +1,99 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "allocation_counter.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace vkb
+{
+namespace
+{
+thread_local uint64_t thread_allocation_count{0};
+}        // namespace
+
+uint64_t get_thread_allocation_count()
+{
+	return thread_allocation_count;
+}
+
+#if defined(VKB_ALLOCATION_COUNTER)
+namespace
+{
+void *counted_allocate(std::size_t size)
+{
+	++thread_allocation_count;
+
+	if (size == 0)
+	{
+		size = 1;
+	}
+
+	while (true)
+	{
+		if (void *ptr = std::malloc(size))
+		{
+			return ptr;
+		}
+
+		auto new_handler = std::get_new_handler();
+
+		if (!new_handler)
+		{
+			throw std::bad_alloc{};
+		}
+
+		new_handler();
+	}
+}
+}        // namespace
+#endif
+}        // namespace vkb
+
+#if defined(VKB_ALLOCATION_COUNTER)
+// The nothrow versions of the default operators call these ones, so they are counted as well
+void *operator new(std::size_t size)
+{
+	return vkb::counted_allocate(size);
+}
+
+void *operator new[](std::size_t size)
+{
+	return vkb::counted_allocate(size);
+}
+
+void operator delete(void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+#endif
@@ -17,7 +17,11 @@
 
 #include "command_buffer.h"
 
+#include <atomic>
+#include <cstring>
+
 #include "command_pool.h"
+#include "common/allocation_counter.h"
 #include "common/error.h"
 #include "device.h"
 #include "rendering/render_frame.h"
@@ -25,9 +29,19 @@
 
 namespace vkb
 {
+namespace
+{
+// State command counts of the command buffers ended since the stats were last sampled
+std::atomic<uint64_t> emitted_state_commands{0};
+
+std::atomic<uint64_t> filtered_state_commands{0};
+}        // namespace
+
 CommandBuffer::CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level) :
     command_pool{command_pool},
+    device_table{command_pool.get_device().get_table()},
     max_push_constants_size{command_pool.get_device().get_gpu().get_properties().limits.maxPushConstantsSize},
+    push_constant_data(max_push_constants_size),
     level{level}
 {
 	VkCommandBufferAllocateInfo allocate_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
@@ -55,15 +69,30 @@ CommandBuffer::~CommandBuffer()
 
 CommandBuffer::CommandBuffer(CommandBuffer &&other) :
     command_pool{other.command_pool},
+    device_table{other.device_table},
     level{other.level},
     handle{other.handle},
     state{other.state},
-    update_after_bind{other.update_after_bind}
+    max_push_constants_size{other.max_push_constants_size},
+    push_constant_data{std::move(other.push_constant_data)},
+    update_after_bind{other.update_after_bind},
+    async_pipelines{other.async_pipelines},
+    fallback_pipeline{other.fallback_pipeline}
 {
 	other.handle = VK_NULL_HANDLE;
 	other.state  = State::Invalid;
 }
 
+CommandBuffer::StateCommandCounts CommandBuffer::reset_state_command_counts()
+{
+	StateCommandCounts counts;
+
+	counts.emitted  = emitted_state_commands.exchange(0);
+	counts.filtered = filtered_state_commands.exchange(0);
+
+	return counts;
+}
+
 Device &CommandBuffer::get_device()
 {
 	return command_pool.get_device();
@@ -81,7 +110,7 @@ bool CommandBuffer::is_recording() const
 
 void CommandBuffer::clear(VkClearAttachment attachment, VkClearRect rect)
 {
-	vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
+	device_table.vkCmdClearAttachments(handle, 1, &attachment, 1, &rect);
 }
 
 VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, CommandBuffer *primary_cmd_buf)
@@ -111,8 +140,15 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const RenderPass
 	// Reset state
 	pipeline_state.reset();
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
-	stored_push_constants.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
+	recorded_state       = {};
+	state_command_counts = {};
+
+	push_constant_size        = 0;
+	push_constant_written_end = 0;
+	push_constant_dirty_begin = 0;
+	push_constant_dirty_end   = 0;
+	push_constant_layout      = VK_NULL_HANDLE;
 
 	VkCommandBufferBeginInfo       begin_info{VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
 	VkCommandBufferInheritanceInfo inheritance = {VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
@@ -132,7 +168,7 @@ VkResult CommandBuffer::begin(VkCommandBufferUsageFlags flags, const RenderPass
 		begin_info.pInheritanceInfo = &inheritance;
 	}
 
-	return vkBeginCommandBuffer(get_handle(), &begin_info);
+	return device_table.vkBeginCommandBuffer(get_handle(), &begin_info);
 }
 
 VkResult CommandBuffer::end()
@@ -144,20 +180,33 @@ VkResult CommandBuffer::end()
 		return VK_NOT_READY;
 	}
 
-	vkEndCommandBuffer(get_handle());
+	device_table.vkEndCommandBuffer(get_handle());
 
 	state = State::Executable;
 
+	emitted_state_commands += state_command_counts.emitted;
+	filtered_state_commands += state_command_counts.filtered;
+
+	state_command_counts = {};
+
 	return VK_SUCCESS;
 }
 
-void CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
+bool CommandBuffer::flush(VkPipelineBindPoint pipeline_bind_point)
 {
-	flush_pipeline_state(pipeline_bind_point);
+	if (!flush_pipeline_state(pipeline_bind_point))
+	{
+		// The command is skipped, the push constants it changed are pushed by the next one
+		push_constant_size = 0;
+
+		return false;
+	}
 
 	flush_push_constants();
 
 	flush_descriptor_state(pipeline_bind_point);
+
+	return true;
 }
 
 void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<VkClearValue> &clear_values, const std::vector<std::unique_ptr<Subpass>> &subpasses, VkSubpassContents contents)
@@ -165,7 +214,7 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const s
 	// Reset state
 	pipeline_state.reset();
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
 
 	auto &render_pass = get_render_pass(render_target, load_store_infos, subpasses);
 	auto &framebuffer = get_device().get_resource_cache().request_framebuffer(render_target, render_pass);
@@ -202,7 +251,9 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const R
 		last_render_area_extent = begin_info.renderArea.extent;
 	}
 
-	vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+	device_table.vkCmdBeginRenderPass(get_handle(), &begin_info, contents);
+
+	current_subpass_contents = contents;
 
 	// Update blend state attachments for first subpass
 	auto blend_state = pipeline_state.get_color_blend_state();
@@ -210,7 +261,7 @@ void CommandBuffer::begin_render_pass(const RenderTarget &render_target, const R
 	pipeline_state.set_color_blend_state(blend_state);
 }
 
-void CommandBuffer::next_subpass()
+void CommandBuffer::next_subpass(VkSubpassContents contents)
 {
 	// Increment subpass index
 	pipeline_state.set_subpass_index(pipeline_state.get_subpass_index() + 1);
@@ -222,17 +273,28 @@ void CommandBuffer::next_subpass()
 
 	// Reset descriptor sets
 	resource_binding_state.reset();
-	descriptor_set_layout_binding_state.clear();
+	descriptor_set_layout_binding_state.fill(nullptr);
+
+	// Start appending push constants from the beginning of the block
+	push_constant_size = 0;
 
-	// Clear stored push constants
-	stored_push_constants.clear();
+	device_table.vkCmdNextSubpass(get_handle(), contents);
 
-	vkCmdNextSubpass(get_handle(), VK_SUBPASS_CONTENTS_INLINE);
+	current_subpass_contents = contents;
+}
+
+VkSubpassContents CommandBuffer::get_current_subpass_contents() const
+{
+	return current_subpass_contents;
 }
 
 void CommandBuffer::execute_commands(CommandBuffer &secondary_command_buffer)
 {
-	vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+	device_table.vkCmdExecuteCommands(get_handle(), 1, &secondary_command_buffer.get_handle());
+
+	// The state set by the secondary command buffer is undefined in this one
+	recorded_state       = {};
+	push_constant_layout = VK_NULL_HANDLE;
 }
 
 void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_command_buffers)
@@ -240,12 +302,113 @@ void CommandBuffer::execute_commands(std::vector<CommandBuffer *> &secondary_com
 	std::vector<VkCommandBuffer> sec_cmd_buf_handles(secondary_command_buffers.size(), VK_NULL_HANDLE);
 	std::transform(secondary_command_buffers.begin(), secondary_command_buffers.end(), sec_cmd_buf_handles.begin(),
 	               [](const vkb::CommandBuffer *sec_cmd_buf) { return sec_cmd_buf->get_handle(); });
-	vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+	device_table.vkCmdExecuteCommands(get_handle(), to_u32(sec_cmd_buf_handles.size()), sec_cmd_buf_handles.data());
+
+	// The state set by the secondary command buffers is undefined in this one
+	recorded_state       = {};
+	push_constant_layout = VK_NULL_HANDLE;
 }
 
 void CommandBuffer::end_render_pass()
 {
-	vkCmdEndRenderPass(get_handle());
+	device_table.vkCmdEndRenderPass(get_handle());
+}
+
+void CommandBuffer::inherit_state(const CommandBuffer &primary_cmd_buf)
+{
+	assert(level == VK_COMMAND_BUFFER_LEVEL_SECONDARY && is_recording() && "Only a recording secondary command buffer can inherit state");
+
+	// Nothing is bound in this command buffer yet, so the whole state is flushed by the next draw
+	pipeline_state = primary_cmd_buf.pipeline_state;
+	pipeline_state.set_dirty();
+
+	resource_binding_state = primary_cmd_buf.resource_binding_state;
+	resource_binding_state.set_dirty();
+
+	descriptor_set_layout_binding_state.fill(nullptr);
+
+	// Dynamic state is not inherited by secondary command buffers
+	const auto &primary_state = primary_cmd_buf.recorded_state;
+
+	for (uint32_t index = 0; index < MAX_TRACKED_BINDINGS; ++index)
+	{
+		if (primary_state.viewport_mask & (1u << index))
+		{
+			set_viewport(index, {primary_state.viewports[index]});
+		}
+
+		if (primary_state.scissor_mask & (1u << index))
+		{
+			set_scissor(index, {primary_state.scissors[index]});
+		}
+	}
+}
+
+size_t CommandBuffer::get_state_hash() const
+{
+	size_t result = 0;
+
+	if (current_render_pass.render_pass && current_render_pass.framebuffer)
+	{
+		hash_combine(result, current_render_pass.render_pass->get_handle());
+		hash_combine(result, current_render_pass.framebuffer->get_handle());
+	}
+
+	hash_combine(result, pipeline_state.get_hash());
+	hash_combine(result, pipeline_state.get_subpass_index());
+
+	auto bound_sets = resource_binding_state.get_bound_sets();
+
+	for (uint32_t set = 0; set < ResourceBindingState::MAX_SETS; ++set)
+	{
+		if (!(bound_sets & (1u << set)))
+		{
+			continue;
+		}
+
+		const auto &resource_set   = resource_binding_state.get_resource_set(set);
+		auto        bound_bindings = resource_set.get_bound_bindings();
+
+		hash_combine(result, set);
+
+		for (uint32_t binding = 0; binding < ResourceSet::MAX_BINDINGS; ++binding)
+		{
+			if (bound_bindings & (1u << binding))
+			{
+				hash_combine(result, binding);
+				hash_combine(result, resource_set.get_binding_hash(binding, true));
+			}
+		}
+	}
+
+	for (uint32_t index = 0; index < MAX_TRACKED_BINDINGS; ++index)
+	{
+		if (recorded_state.viewport_mask & (1u << index))
+		{
+			const auto &viewport = recorded_state.viewports[index];
+
+			hash_combine(result, index);
+			hash_combine(result, viewport.x);
+			hash_combine(result, viewport.y);
+			hash_combine(result, viewport.width);
+			hash_combine(result, viewport.height);
+			hash_combine(result, viewport.minDepth);
+			hash_combine(result, viewport.maxDepth);
+		}
+
+		if (recorded_state.scissor_mask & (1u << index))
+		{
+			const auto &scissor = recorded_state.scissors[index];
+
+			hash_combine(result, index);
+			hash_combine(result, scissor.offset.x);
+			hash_combine(result, scissor.offset.y);
+			hash_combine(result, scissor.extent.width);
+			hash_combine(result, scissor.extent.height);
+		}
+	}
+
+	return result;
 }
 
 void CommandBuffer::bind_pipeline_layout(PipelineLayout &pipeline_layout)
@@ -260,17 +423,39 @@ void CommandBuffer::set_specialization_constant(uint32_t constant_id, const std:
 
 void CommandBuffer::push_constants(const std::vector<uint8_t> &values)
 {
-	uint32_t push_constant_size = to_u32(stored_push_constants.size() + values.size());
+	write_push_constants(push_constant_size, values.data(), to_u32(values.size()));
+}
 
-	if (push_constant_size > max_push_constants_size)
+void CommandBuffer::write_push_constants(uint32_t offset, const void *data, uint32_t size)
+{
+	if (offset + size > max_push_constants_size)
 	{
-		LOGE("Push constant limit of {} exceeded (pushing {} bytes for a total of {} bytes)", max_push_constants_size, values.size(), push_constant_size);
+		LOGE("Push constant limit of {} exceeded (pushing {} bytes at offset {})", max_push_constants_size, size, offset);
 		throw std::runtime_error("Push constant limit exceeded.");
 	}
-	else
+
+	auto destination = push_constant_data.data() + offset;
+
+	// Bytes which were never written must be pushed even if they match the initial zeros
+	if (offset + size > push_constant_written_end || std::memcmp(destination, data, size) != 0)
 	{
-		stored_push_constants.insert(stored_push_constants.end(), values.begin(), values.end());
+		std::memcpy(destination, data, size);
+
+		if (push_constant_dirty_begin == push_constant_dirty_end)
+		{
+			push_constant_dirty_begin = offset;
+			push_constant_dirty_end   = offset + size;
+		}
+		else
+		{
+			push_constant_dirty_begin = std::min(push_constant_dirty_begin, offset);
+			push_constant_dirty_end   = std::max(push_constant_dirty_end, offset + size);
+		}
+
+		push_constant_written_end = std::max(push_constant_written_end, offset + size);
 	}
+
+	push_constant_size = offset + size;
 }
 
 void CommandBuffer::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
@@ -295,15 +480,51 @@ void CommandBuffer::bind_input(const core::ImageView &image_view, uint32_t set,
 
 void CommandBuffer::bind_vertex_buffers(uint32_t first_binding, const std::vector<std::reference_wrapper<const vkb::core::Buffer>> &buffers, const std::vector<VkDeviceSize> &offsets)
 {
+	bool redundant = first_binding + buffers.size() <= MAX_TRACKED_BINDINGS;
+
+	for (uint32_t i = 0; redundant && i < buffers.size(); ++i)
+	{
+		uint32_t binding = first_binding + i;
+
+		redundant = (recorded_state.vertex_buffer_mask & (1u << binding)) &&
+		            recorded_state.vertex_buffers[binding] == buffers[i].get().get_handle() &&
+		            recorded_state.vertex_buffer_offsets[binding] == offsets[i];
+	}
+
+	if (skip_state_command(redundant))
+	{
+		return;
+	}
+
 	std::vector<VkBuffer> buffer_handles(buffers.size(), VK_NULL_HANDLE);
 	std::transform(buffers.begin(), buffers.end(), buffer_handles.begin(),
 	               [](const core::Buffer &buffer) { return buffer.get_handle(); });
-	vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+	device_table.vkCmdBindVertexBuffers(get_handle(), first_binding, to_u32(buffer_handles.size()), buffer_handles.data(), offsets.data());
+
+	for (uint32_t i = 0; i < buffer_handles.size() && first_binding + i < MAX_TRACKED_BINDINGS; ++i)
+	{
+		uint32_t binding = first_binding + i;
+
+		recorded_state.vertex_buffers[binding]        = buffer_handles[i];
+		recorded_state.vertex_buffer_offsets[binding] = offsets[i];
+		recorded_state.vertex_buffer_mask |= 1u << binding;
+	}
 }
 
 void CommandBuffer::bind_index_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkIndexType index_type)
 {
-	vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+	if (skip_state_command(recorded_state.index_buffer == buffer.get_handle() &&
+	                       recorded_state.index_buffer_offset == offset &&
+	                       recorded_state.index_type == index_type))
+	{
+		return;
+	}
+
+	device_table.vkCmdBindIndexBuffer(get_handle(), buffer.get_handle(), offset, index_type);
+
+	recorded_state.index_buffer        = buffer.get_handle();
+	recorded_state.index_buffer_offset = offset;
+	recorded_state.index_type          = index_type;
 }
 
 void CommandBuffer::bind_lighting(LightingState &lighting_state, uint32_t set, uint32_t binding)
@@ -352,113 +573,200 @@ void CommandBuffer::set_color_blend_state(const ColorBlendState &state_info)
 
 void CommandBuffer::set_viewport(uint32_t first_viewport, const std::vector<VkViewport> &viewports)
 {
-	vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+	bool redundant = first_viewport + viewports.size() <= MAX_TRACKED_BINDINGS;
+
+	for (uint32_t i = 0; redundant && i < viewports.size(); ++i)
+	{
+		uint32_t index = first_viewport + i;
+
+		redundant = (recorded_state.viewport_mask & (1u << index)) &&
+		            std::memcmp(&recorded_state.viewports[index], &viewports[i], sizeof(VkViewport)) == 0;
+	}
+
+	if (skip_state_command(redundant))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetViewport(get_handle(), first_viewport, to_u32(viewports.size()), viewports.data());
+
+	for (uint32_t i = 0; i < viewports.size() && first_viewport + i < MAX_TRACKED_BINDINGS; ++i)
+	{
+		recorded_state.viewports[first_viewport + i] = viewports[i];
+		recorded_state.viewport_mask |= 1u << (first_viewport + i);
+	}
 }
 
 void CommandBuffer::set_scissor(uint32_t first_scissor, const std::vector<VkRect2D> &scissors)
 {
-	vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+	bool redundant = first_scissor + scissors.size() <= MAX_TRACKED_BINDINGS;
+
+	for (uint32_t i = 0; redundant && i < scissors.size(); ++i)
+	{
+		uint32_t index = first_scissor + i;
+
+		redundant = (recorded_state.scissor_mask & (1u << index)) &&
+		            std::memcmp(&recorded_state.scissors[index], &scissors[i], sizeof(VkRect2D)) == 0;
+	}
+
+	if (skip_state_command(redundant))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetScissor(get_handle(), first_scissor, to_u32(scissors.size()), scissors.data());
+
+	for (uint32_t i = 0; i < scissors.size() && first_scissor + i < MAX_TRACKED_BINDINGS; ++i)
+	{
+		recorded_state.scissors[first_scissor + i] = scissors[i];
+		recorded_state.scissor_mask |= 1u << (first_scissor + i);
+	}
 }
 
 void CommandBuffer::set_line_width(float line_width)
 {
-	vkCmdSetLineWidth(get_handle(), line_width);
+	if (skip_state_command(recorded_state.has_line_width && recorded_state.line_width == line_width))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetLineWidth(get_handle(), line_width);
+
+	recorded_state.has_line_width = true;
+	recorded_state.line_width     = line_width;
 }
 
 void CommandBuffer::set_depth_bias(float depth_bias_constant_factor, float depth_bias_clamp, float depth_bias_slope_factor)
 {
-	vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+	std::array<float, 3> depth_bias{depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor};
+
+	if (skip_state_command(recorded_state.has_depth_bias && recorded_state.depth_bias == depth_bias))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetDepthBias(get_handle(), depth_bias_constant_factor, depth_bias_clamp, depth_bias_slope_factor);
+
+	recorded_state.has_depth_bias = true;
+	recorded_state.depth_bias     = depth_bias;
 }
 
 void CommandBuffer::set_blend_constants(const std::array<float, 4> &blend_constants)
 {
-	vkCmdSetBlendConstants(get_handle(), blend_constants.data());
+	if (skip_state_command(recorded_state.has_blend_constants && recorded_state.blend_constants == blend_constants))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetBlendConstants(get_handle(), blend_constants.data());
+
+	recorded_state.has_blend_constants = true;
+	recorded_state.blend_constants     = blend_constants;
 }
 
 void CommandBuffer::set_depth_bounds(float min_depth_bounds, float max_depth_bounds)
 {
-	vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+	std::array<float, 2> depth_bounds{min_depth_bounds, max_depth_bounds};
+
+	if (skip_state_command(recorded_state.has_depth_bounds && recorded_state.depth_bounds == depth_bounds))
+	{
+		return;
+	}
+
+	device_table.vkCmdSetDepthBounds(get_handle(), min_depth_bounds, max_depth_bounds);
+
+	recorded_state.has_depth_bounds = true;
+	recorded_state.depth_bounds     = depth_bounds;
 }
 
 void CommandBuffer::draw(uint32_t vertex_count, uint32_t instance_count, uint32_t first_vertex, uint32_t first_instance)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
-	vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
+	device_table.vkCmdDraw(get_handle(), vertex_count, instance_count, first_vertex, first_instance);
 }
 
 void CommandBuffer::draw_indexed(uint32_t index_count, uint32_t instance_count, uint32_t first_index, int32_t vertex_offset, uint32_t first_instance)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
-	vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
+	device_table.vkCmdDrawIndexed(get_handle(), index_count, instance_count, first_index, vertex_offset, first_instance);
 }
 
 void CommandBuffer::draw_indexed_indirect(const core::Buffer &buffer, VkDeviceSize offset, uint32_t draw_count, uint32_t stride)
 {
-	flush(VK_PIPELINE_BIND_POINT_GRAPHICS);
+	if (!flush(VK_PIPELINE_BIND_POINT_GRAPHICS))
+	{
+		return;
+	}
 
-	vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
+	device_table.vkCmdDrawIndexedIndirect(get_handle(), buffer.get_handle(), offset, draw_count, stride);
 }
 
 void CommandBuffer::dispatch(uint32_t group_count_x, uint32_t group_count_y, uint32_t group_count_z)
 {
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
+	device_table.vkCmdDispatch(get_handle(), group_count_x, group_count_y, group_count_z);
 }
 
 void CommandBuffer::dispatch_indirect(const core::Buffer &buffer, VkDeviceSize offset)
 {
 	flush(VK_PIPELINE_BIND_POINT_COMPUTE);
 
-	vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
+	device_table.vkCmdDispatchIndirect(get_handle(), buffer.get_handle(), offset);
 }
 
 void CommandBuffer::update_buffer(const core::Buffer &buffer, VkDeviceSize offset, const std::vector<uint8_t> &data)
 {
-	vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
+	device_table.vkCmdUpdateBuffer(get_handle(), buffer.get_handle(), offset, data.size(), data.data());
 }
 
 void CommandBuffer::blit_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageBlit> &regions)
 {
-	vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
+	device_table.vkCmdBlitImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                            dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                            to_u32(regions.size()), regions.data(), VK_FILTER_NEAREST);
 }
 
 void CommandBuffer::resolve_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageResolve> &regions)
 {
-	vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	                  dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                  to_u32(regions.size()), regions.data());
+	device_table.vkCmdResolveImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                               to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::copy_buffer(const core::Buffer &src_buffer, const core::Buffer &dst_buffer, VkDeviceSize size)
 {
 	VkBufferCopy copy_region = {};
 	copy_region.size         = size;
-	vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
+	device_table.vkCmdCopyBuffer(get_handle(), src_buffer.get_handle(), dst_buffer.get_handle(), 1, &copy_region);
 }
 
 void CommandBuffer::copy_image(const core::Image &src_img, const core::Image &dst_img, const std::vector<VkImageCopy> &regions)
 {
-	vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
-	               dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	               to_u32(regions.size()), regions.data());
+	device_table.vkCmdCopyImage(get_handle(), src_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL,
+	                            dst_img.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                            to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::copy_buffer_to_image(const core::Buffer &buffer, const core::Image &image, const std::vector<VkBufferImageCopy> &regions)
 {
-	vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
-	                       image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
-	                       to_u32(regions.size()), regions.data());
+	device_table.vkCmdCopyBufferToImage(get_handle(), buffer.get_handle(),
+	                                    image.get_handle(), VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+	                                    to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::copy_image_to_buffer(const core::Image &image, VkImageLayout image_layout, const core::Buffer &buffer, const std::vector<VkBufferImageCopy> &regions)
 {
-	vkCmdCopyImageToBuffer(get_handle(), image.get_handle(), image_layout,
-	                       buffer.get_handle(), to_u32(regions.size()), regions.data());
+	device_table.vkCmdCopyImageToBuffer(get_handle(), image.get_handle(), image_layout,
+	                                    buffer.get_handle(), to_u32(regions.size()), regions.data());
 }
 
 void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, const ImageMemoryBarrier &memory_barrier)
@@ -488,7 +796,7 @@ void CommandBuffer::image_memory_barrier(const core::ImageView &image_view, cons
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
-	vkCmdPipelineBarrier(
+	device_table.vkCmdPipelineBarrier(
 	    get_handle(),
 	    src_stage_mask,
 	    dst_stage_mask,
@@ -511,7 +819,7 @@ void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSi
 	VkPipelineStageFlags src_stage_mask = memory_barrier.src_stage_mask;
 	VkPipelineStageFlags dst_stage_mask = memory_barrier.dst_stage_mask;
 
-	vkCmdPipelineBarrier(
+	device_table.vkCmdPipelineBarrier(
 	    get_handle(),
 	    src_stage_mask,
 	    dst_stage_mask,
@@ -521,242 +829,658 @@ void CommandBuffer::buffer_memory_barrier(const core::Buffer &buffer, VkDeviceSi
 	    0, nullptr);
 }
 
-void CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
+bool CommandBuffer::flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point)
 {
 	// Create a new pipeline only if the graphics state changed
 	if (!pipeline_state.is_dirty())
 	{
-		return;
+		return true;
+	}
+
+	// Create and bind pipeline
+	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS && async_pipelines)
+	{
+		pipeline_state.set_render_pass(*current_render_pass.render_pass);
+		auto pipeline = get_device().get_resource_cache().request_graphics_pipeline_async(pipeline_state);
+
+		if (pipeline == nullptr)
+		{
+			// The state stays dirty, so that the pipeline is requested again by the next command
+			if (fallback_pipeline == nullptr)
+			{
+				return false;
+			}
+
+			pipeline = fallback_pipeline;
+		}
+		else
+		{
+			pipeline_state.clear_dirty();
+		}
+
+		device_table.vkCmdBindPipeline(get_handle(),
+		                               pipeline_bind_point,
+		                               pipeline->get_handle());
+
+		return true;
 	}
 
 	pipeline_state.clear_dirty();
 
-	// Create and bind pipeline
 	if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_GRAPHICS)
 	{
 		pipeline_state.set_render_pass(*current_render_pass.render_pass);
 		auto &pipeline = get_device().get_resource_cache().request_graphics_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		device_table.vkCmdBindPipeline(get_handle(),
+		                               pipeline_bind_point,
+		                               pipeline.get_handle());
 	}
 	else if (pipeline_bind_point == VK_PIPELINE_BIND_POINT_COMPUTE)
 	{
 		auto &pipeline = get_device().get_resource_cache().request_compute_pipeline(pipeline_state);
 
-		vkCmdBindPipeline(get_handle(),
-		                  pipeline_bind_point,
-		                  pipeline.get_handle());
+		device_table.vkCmdBindPipeline(get_handle(),
+		                               pipeline_bind_point,
+		                               pipeline.get_handle());
 	}
 	else
 	{
 		throw "Only graphics and compute pipeline bind points are supported now";
 	}
+
+	return true;
 }
 
 void CommandBuffer::flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point)
 {
 	assert(command_pool.get_render_frame() && "The command pool must be associated to a render frame");
 
+#if defined(VKB_ALLOCATION_COUNTER)
+	auto allocation_count = get_thread_allocation_count();
+
+	// The scratch vectors grow during the first flushes of a command buffer
+	auto scratch_capacity = dynamic_offsets.capacity() + bindings_to_update.capacity() + push_descriptor_infos.capacity() + push_descriptor_writes.capacity();
+
+	bool created_descriptor_set{false};
+#endif
+
 	const auto &pipeline_layout = pipeline_state.get_pipeline_layout();
 
-	std::unordered_set<uint32_t> update_descriptor_sets;
+	// Bitmask of the sets that must be bound again even if their resources did not change
+	uint32_t update_sets{0};
+
+	// Check if the bound descriptor set layouts still match the pipeline layout
+	// If one changed, add the set so that the command buffer later updates it
+	// If one does not exist in the pipeline layout anymore, stop tracking it
+	for (uint32_t descriptor_set_id = 0; descriptor_set_id < ResourceBindingState::MAX_SETS; ++descriptor_set_id)
+	{
+		auto &bound_descriptor_set_layout = descriptor_set_layout_binding_state[descriptor_set_id];
+
+		if (bound_descriptor_set_layout == nullptr)
+		{
+			continue;
+		}
+
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+		{
+			bound_descriptor_set_layout = nullptr;
+		}
+		else if (bound_descriptor_set_layout->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
+		{
+			update_sets |= 1u << descriptor_set_id;
+		}
+	}
+
+	// Resource sets which changed or need to be bound again
+	uint32_t flush_sets = (resource_binding_state.get_dirty_sets() | update_sets) & resource_binding_state.get_bound_sets();
+
+	resource_binding_state.clear_dirty();
 
-	// Iterate over the shader sets to check if they have already been bound
-	// If they have, add the set so that the command buffer later updates it
-	for (auto &set_it : pipeline_layout.get_shader_sets())
+	for (uint32_t descriptor_set_id = 0; flush_sets >> descriptor_set_id; ++descriptor_set_id)
 	{
-		uint32_t descriptor_set_id = set_it.first;
+		if (!(flush_sets & (1u << descriptor_set_id)))
+		{
+			continue;
+		}
+
+		auto &resource_set = resource_binding_state.get_resource_set(descriptor_set_id);
+
+		// Clear dirty flag for resource set
+		resource_set.clear_dirty();
+
+		// Skip resource set if a descriptor set layout doesn't exist for it
+		if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+		{
+			continue;
+		}
 
-		auto descriptor_set_layout_it = descriptor_set_layout_binding_state.find(descriptor_set_id);
+		auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
 
-		if (descriptor_set_layout_it != descriptor_set_layout_binding_state.end())
+		// Make descriptor set layout bound for current set
+		descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+
+		// Push descriptor sets are written directly into the command buffer
+		if (descriptor_set_layout.is_push_descriptor())
 		{
-			if (descriptor_set_layout_it->second->get_handle() != pipeline_layout.get_descriptor_set_layout(descriptor_set_id).get_handle())
+			push_descriptor_set(pipeline_bind_point, pipeline_layout, descriptor_set_layout, resource_set);
+			continue;
+		}
+
+		// The scratch vectors keep their capacity across flushes
+		dynamic_offsets.clear();
+
+		// The bindings we want to update before binding, if empty we update all bindings
+		bindings_to_update.clear();
+
+		// Key of the descriptor set, combined from the hashes kept up to date by the resource set
+		size_t bindings_hash{0};
+
+		uint32_t bound_bindings = resource_set.get_bound_bindings();
+
+		// Iterate over all bound bindings, in ascending order
+		for (uint32_t binding_index = 0; binding_index < ResourceSet::MAX_BINDINGS; ++binding_index)
+		{
+			if (!(bound_bindings & (1u << binding_index)))
 			{
-				update_descriptor_sets.emplace(descriptor_set_id);
+				continue;
+			}
+
+			// Check if binding exists in the pipeline layout
+			auto binding_info = descriptor_set_layout.find_layout_binding(binding_index);
+
+			if (!binding_info)
+			{
+				continue;
+			}
+
+			bool dynamic_buffer = is_dynamic_buffer_descriptor_type(binding_info->descriptorType);
+
+			// Offsets of dynamic buffers are not part of the descriptor set
+			hash_combine(bindings_hash, binding_index);
+			hash_combine(bindings_hash, resource_set.get_binding_hash(binding_index, !dynamic_buffer));
+
+			// If update after bind is enabled, we store the binding index of each binding that need to be updated before being bound
+			if (update_after_bind && !(descriptor_set_layout.get_layout_binding_flag(binding_index) & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT))
+			{
+				bindings_to_update.push_back(binding_index);
+			}
+
+			if (dynamic_buffer)
+			{
+				uint32_t bound_elements = resource_set.get_bound_elements(binding_index);
+
+				for (uint32_t array_element = 0; array_element < ResourceSet::MAX_ARRAY_ELEMENTS; ++array_element)
+				{
+					if (bound_elements & (1u << array_element))
+					{
+						auto &resource_info = resource_set.get_resource(binding_index, array_element);
+
+						if (resource_info.buffer != nullptr)
+						{
+							dynamic_offsets.push_back(to_u32(resource_info.offset));
+						}
+					}
+				}
 			}
 		}
+
+		auto &render_frame = *command_pool.get_render_frame();
+
+		// Look for a descriptor set with the same resources, and only gather the buffer infos and image infos to create one if it is missing
+		auto descriptor_set = render_frame.find_descriptor_set(descriptor_set_layout, bindings_hash, command_pool.get_thread_index());
+
+		// The key is only a hash of the resources, so check that the descriptor set found holds them
+		bool hash_collision = descriptor_set && !matches_binding_infos(resource_set, descriptor_set_layout, *descriptor_set);
+
+		if (!descriptor_set || hash_collision)
+		{
+			BindingMap<VkDescriptorBufferInfo> buffer_infos;
+			BindingMap<VkDescriptorImageInfo>  image_infos;
+
+			get_binding_infos(resource_set, descriptor_set_layout, buffer_infos, image_infos);
+
+			// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
+			if (hash_collision)
+			{
+				// Fall back to a descriptor set keyed by the infos themselves
+				descriptor_set = &render_frame.request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
+			}
+			else
+			{
+				descriptor_set = &render_frame.request_descriptor_set(descriptor_set_layout, bindings_hash, buffer_infos, image_infos, command_pool.get_thread_index());
+			}
+
+#if defined(VKB_ALLOCATION_COUNTER)
+			created_descriptor_set = true;
+#endif
+		}
+
+		descriptor_set->update(bindings_to_update);
+
+		VkDescriptorSet descriptor_set_handle = descriptor_set->get_handle();
+
+		// Bind descriptor set
+		device_table.vkCmdBindDescriptorSets(get_handle(),
+		                                     pipeline_bind_point,
+		                                     pipeline_layout.get_handle(),
+		                                     descriptor_set_id,
+		                                     1, &descriptor_set_handle,
+		                                     to_u32(dynamic_offsets.size()),
+		                                     dynamic_offsets.data());
+	}
+
+#if defined(VKB_ALLOCATION_COUNTER)
+	// Once descriptor sets are cached, flushing the descriptor state should not allocate memory
+	static std::atomic<bool> reported{false};
+
+	bool scratch_grew = dynamic_offsets.capacity() + bindings_to_update.capacity() + push_descriptor_infos.capacity() + push_descriptor_writes.capacity() != scratch_capacity;
+
+	if (!created_descriptor_set && !scratch_grew && get_thread_allocation_count() != allocation_count && !reported.exchange(true))
+	{
+		LOGW("Flushing the descriptor state made {} heap allocations without creating a descriptor set", get_thread_allocation_count() - allocation_count);
 	}
+#endif
+}
+
+void CommandBuffer::get_binding_infos(const ResourceSet &resource_set, DescriptorSetLayout &descriptor_set_layout, BindingMap<VkDescriptorBufferInfo> &buffer_infos, BindingMap<VkDescriptorImageInfo> &image_infos)
+{
+	uint32_t bound_bindings = resource_set.get_bound_bindings();
 
-	// Validate that the bound descriptor set layouts exist in the pipeline layout
-	for (auto set_it = descriptor_set_layout_binding_state.begin(); set_it != descriptor_set_layout_binding_state.end();)
+	for (uint32_t binding_index = 0; binding_index < ResourceSet::MAX_BINDINGS; ++binding_index)
 	{
-		if (!pipeline_layout.has_descriptor_set_layout(set_it->first))
+		if (!(bound_bindings & (1u << binding_index)))
 		{
-			set_it = descriptor_set_layout_binding_state.erase(set_it);
+			continue;
 		}
-		else
+
+		// Check if binding exists in the pipeline layout
+		auto binding_info = descriptor_set_layout.find_layout_binding(binding_index);
+
+		if (!binding_info)
 		{
-			++set_it;
+			continue;
+		}
+
+		uint32_t bound_elements = resource_set.get_bound_elements(binding_index);
+
+		// Iterate over all binding resources
+		for (uint32_t array_element = 0; array_element < ResourceSet::MAX_ARRAY_ELEMENTS; ++array_element)
+		{
+			if (!(bound_elements & (1u << array_element)))
+			{
+				continue;
+			}
+
+			auto &resource_info = resource_set.get_resource(binding_index, array_element);
+
+			DescriptorUpdateInfo descriptor_info;
+
+			if (!get_descriptor_info(resource_info, *binding_info, descriptor_info))
+			{
+				continue;
+			}
+
+			if (resource_info.buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+			{
+				buffer_infos[binding_index][array_element] = descriptor_info.buffer;
+			}
+			else
+			{
+				image_infos[binding_index][array_element] = descriptor_info.image;
+			}
 		}
 	}
+}
 
-	// Check if a descriptor set needs to be created
-	if (resource_binding_state.is_dirty() || !update_descriptor_sets.empty())
+bool CommandBuffer::matches_binding_infos(const ResourceSet &resource_set, DescriptorSetLayout &descriptor_set_layout, DescriptorSet &descriptor_set)
+{
+	auto &buffer_infos = descriptor_set.get_buffer_infos();
+	auto &image_infos  = descriptor_set.get_image_infos();
+
+	size_t descriptor_count{0};
+
+	uint32_t bound_bindings = resource_set.get_bound_bindings();
+
+	for (uint32_t binding_index = 0; binding_index < ResourceSet::MAX_BINDINGS; ++binding_index)
 	{
-		resource_binding_state.clear_dirty();
+		if (!(bound_bindings & (1u << binding_index)))
+		{
+			continue;
+		}
+
+		auto binding_info = descriptor_set_layout.find_layout_binding(binding_index);
 
-		// Iterate over all of the resource sets bound by the command buffer
-		for (auto &resource_set_it : resource_binding_state.get_resource_sets())
+		if (!binding_info)
 		{
-			uint32_t descriptor_set_id = resource_set_it.first;
-			auto &   resource_set      = resource_set_it.second;
+			continue;
+		}
+
+		uint32_t bound_elements = resource_set.get_bound_elements(binding_index);
 
-			// Don't update resource set if it's not in the update list OR its state hasn't changed
-			if (!resource_set.is_dirty() && (update_descriptor_sets.find(descriptor_set_id) == update_descriptor_sets.end()))
+		for (uint32_t array_element = 0; array_element < ResourceSet::MAX_ARRAY_ELEMENTS; ++array_element)
+		{
+			if (!(bound_elements & (1u << array_element)))
 			{
 				continue;
 			}
 
-			// Clear dirty flag for resource set
-			resource_binding_state.clear_dirty(descriptor_set_id);
+			auto &resource_info = resource_set.get_resource(binding_index, array_element);
 
-			// Skip resource set if a descriptor set layout doesn't exist for it
-			if (!pipeline_layout.has_descriptor_set_layout(descriptor_set_id))
+			DescriptorUpdateInfo descriptor_info;
+
+			if (!get_descriptor_info(resource_info, *binding_info, descriptor_info))
 			{
 				continue;
 			}
 
-			auto &descriptor_set_layout = pipeline_layout.get_descriptor_set_layout(descriptor_set_id);
+			// Same choice between buffer and image infos as get_binding_infos
+			if (resource_info.buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
+			{
+				auto binding_it = buffer_infos.find(binding_index);
 
-			// Make descriptor set layout bound for current set
-			descriptor_set_layout_binding_state[descriptor_set_id] = &descriptor_set_layout;
+				if (binding_it == buffer_infos.end())
+				{
+					return false;
+				}
 
-			BindingMap<VkDescriptorBufferInfo> buffer_infos;
-			BindingMap<VkDescriptorImageInfo>  image_infos;
+				auto element_it = binding_it->second.find(array_element);
 
-			std::vector<uint32_t> dynamic_offsets;
+				if (element_it == binding_it->second.end() ||
+				    element_it->second.buffer != descriptor_info.buffer.buffer ||
+				    element_it->second.offset != descriptor_info.buffer.offset ||
+				    element_it->second.range != descriptor_info.buffer.range)
+				{
+					return false;
+				}
+			}
+			else
+			{
+				auto binding_it = image_infos.find(binding_index);
 
-			// The bindings we want to update before binding, if empty we update all bindings
-			std::vector<uint32_t> bindings_to_update;
+				if (binding_it == image_infos.end())
+				{
+					return false;
+				}
 
-			// Iterate over all resource bindings
-			for (auto &binding_it : resource_set.get_resource_bindings())
-			{
-				auto  binding_index     = binding_it.first;
-				auto &binding_resources = binding_it.second;
+				auto element_it = binding_it->second.find(array_element);
 
-				// Check if binding exists in the pipeline layout
-				if (auto binding_info = descriptor_set_layout.get_layout_binding(binding_index))
+				if (element_it == binding_it->second.end() ||
+				    element_it->second.sampler != descriptor_info.image.sampler ||
+				    element_it->second.imageView != descriptor_info.image.imageView ||
+				    element_it->second.imageLayout != descriptor_info.image.imageLayout)
 				{
-					// If update after bind is enabled, we store the binding index of each binding that need to be updated before being bound
-					if (update_after_bind && !(descriptor_set_layout.get_layout_binding_flag(binding_index) & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT))
+					return false;
+				}
+			}
+
+			++descriptor_count;
+		}
+	}
+
+	// The descriptor set must not hold more descriptors than the bound resources
+	size_t set_descriptor_count{0};
+
+	for (auto &binding_it : buffer_infos)
+	{
+		set_descriptor_count += binding_it.second.size();
+	}
+
+	for (auto &binding_it : image_infos)
+	{
+		set_descriptor_count += binding_it.second.size();
+	}
+
+	return descriptor_count == set_descriptor_count;
+}
+
+bool CommandBuffer::get_descriptor_info(const ResourceInfo &resource_info, const VkDescriptorSetLayoutBinding &binding_info, DescriptorUpdateInfo &descriptor_info)
+{
+	// Pointer references
+	auto &buffer     = resource_info.buffer;
+	auto &sampler    = resource_info.sampler;
+	auto &image_view = resource_info.image_view;
+
+	// Get buffer info
+	if (buffer != nullptr && is_buffer_descriptor_type(binding_info.descriptorType))
+	{
+		VkDescriptorBufferInfo buffer_info{};
+
+		buffer_info.buffer = resource_info.buffer->get_handle();
+		buffer_info.offset = resource_info.offset;
+		buffer_info.range  = resource_info.range;
+
+		// Offsets of dynamic buffers are given when binding the descriptor set
+		if (is_dynamic_buffer_descriptor_type(binding_info.descriptorType))
+		{
+			buffer_info.offset = 0;
+		}
+
+		descriptor_info.buffer = buffer_info;
+
+		return true;
+	}
+
+	// Get image info
+	if (image_view != nullptr || sampler != VK_NULL_HANDLE)
+	{
+		// Can be null for input attachments
+		VkDescriptorImageInfo image_info{};
+		image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
+		image_info.imageView = image_view->get_handle();
+
+		if (image_view != nullptr)
+		{
+			// Add image layout info based on descriptor type
+			switch (binding_info.descriptorType)
+			{
+				case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+					image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					break;
+				case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
+					if (is_depth_stencil_format(image_view->get_format()))
 					{
-						bindings_to_update.push_back(binding_index);
+						image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
 					}
-
-					// Iterate over all binding resources
-					for (auto &element_it : binding_resources)
+					else
 					{
-						auto  array_element = element_it.first;
-						auto &resource_info = element_it.second;
+						image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+					}
+					break;
+				case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+					image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
+					break;
 
-						// Pointer references
-						auto &buffer     = resource_info.buffer;
-						auto &sampler    = resource_info.sampler;
-						auto &image_view = resource_info.image_view;
+				default:
+					return false;
+			}
+		}
 
-						// Get buffer info
-						if (buffer != nullptr && is_buffer_descriptor_type(binding_info->descriptorType))
-						{
-							VkDescriptorBufferInfo buffer_info{};
+		descriptor_info.image = image_info;
 
-							buffer_info.buffer = resource_info.buffer->get_handle();
-							buffer_info.offset = resource_info.offset;
-							buffer_info.range  = resource_info.range;
+		return true;
+	}
 
-							if (is_dynamic_buffer_descriptor_type(binding_info->descriptorType))
-							{
-								dynamic_offsets.push_back(to_u32(buffer_info.offset));
+	return false;
+}
 
-								buffer_info.offset = 0;
-							}
+void CommandBuffer::push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set)
+{
+	// The scratch vectors keep their capacity across flushes
+	push_descriptor_infos.clear();
+	push_descriptor_writes.clear();
 
-							buffer_infos[binding_index][array_element] = std::move(buffer_info);
-						}
+	uint32_t bound_bindings = resource_set.get_bound_bindings();
 
-						// Get image info
-						else if (image_view != nullptr || sampler != VK_NULL_HANDLE)
-						{
-							// Can be null for input attachments
-							VkDescriptorImageInfo image_info{};
-							image_info.sampler   = sampler ? sampler->get_handle() : VK_NULL_HANDLE;
-							image_info.imageView = image_view->get_handle();
-
-							if (image_view != nullptr)
-							{
-								// Add image layout info based on descriptor type
-								switch (binding_info->descriptorType)
-								{
-									case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										break;
-									case VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT:
-										if (is_depth_stencil_format(image_view->get_format()))
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL;
-										}
-										else
-										{
-											image_info.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-										}
-										break;
-									case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
-										image_info.imageLayout = VK_IMAGE_LAYOUT_GENERAL;
-										break;
-
-									default:
-										continue;
-								}
-							}
-
-							image_infos[binding_index][array_element] = std::move(image_info);
-						}
-					}
-				}
+	for (uint32_t binding_index = 0; binding_index < ResourceSet::MAX_BINDINGS; ++binding_index)
+	{
+		if (!(bound_bindings & (1u << binding_index)))
+		{
+			continue;
+		}
+
+		// Check if binding exists in the pipeline layout
+		auto binding_info = descriptor_set_layout.find_layout_binding(binding_index);
+
+		if (!binding_info)
+		{
+			continue;
+		}
+
+		uint32_t bound_elements = resource_set.get_bound_elements(binding_index);
+
+		for (uint32_t array_element = 0; array_element < ResourceSet::MAX_ARRAY_ELEMENTS; ++array_element)
+		{
+			if (!(bound_elements & (1u << array_element)))
+			{
+				continue;
 			}
 
-			// Request a descriptor set from the render frame, and write the buffer infos and image infos of all the specified bindings
-			auto &descriptor_set = command_pool.get_render_frame()->request_descriptor_set(descriptor_set_layout, buffer_infos, image_infos, command_pool.get_thread_index());
-			descriptor_set.update(bindings_to_update);
+			DescriptorUpdateInfo descriptor_info;
+
+			if (!get_descriptor_info(resource_set.get_resource(binding_index, array_element), *binding_info, descriptor_info))
+			{
+				continue;
+			}
+
+			push_descriptor_infos.push_back(descriptor_info);
+
+			VkWriteDescriptorSet write_descriptor_set{VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+
+			write_descriptor_set.dstBinding      = binding_index;
+			write_descriptor_set.descriptorType  = binding_info->descriptorType;
+			write_descriptor_set.dstArrayElement = array_element;
+			write_descriptor_set.descriptorCount = 1;
+
+			push_descriptor_writes.push_back(write_descriptor_set);
+		}
+	}
+
+	if (push_descriptor_writes.empty())
+	{
+		return;
+	}
 
-			VkDescriptorSet descriptor_set_handle = descriptor_set.get_handle();
+	// Point the writes to their descriptors once the vector of descriptors is not growing anymore
+	for (size_t i = 0; i < push_descriptor_writes.size(); ++i)
+	{
+		auto &write_descriptor_set = push_descriptor_writes[i];
 
-			// Bind descriptor set
-			vkCmdBindDescriptorSets(get_handle(),
-			                        pipeline_bind_point,
-			                        pipeline_layout.get_handle(),
-			                        descriptor_set_id,
-			                        1, &descriptor_set_handle,
-			                        to_u32(dynamic_offsets.size()),
-			                        dynamic_offsets.data());
+		if (is_buffer_descriptor_type(write_descriptor_set.descriptorType))
+		{
+			write_descriptor_set.pBufferInfo = &push_descriptor_infos[i].buffer;
+		}
+		else
+		{
+			write_descriptor_set.pImageInfo = &push_descriptor_infos[i].image;
 		}
 	}
+
+	device_table.vkCmdPushDescriptorSetKHR(get_handle(),
+	                                       pipeline_bind_point,
+	                                       pipeline_layout.get_handle(),
+	                                       descriptor_set_layout.get_index(),
+	                                       to_u32(push_descriptor_writes.size()),
+	                                       push_descriptor_writes.data());
+}
+
+bool CommandBuffer::skip_state_command(bool redundant)
+{
+	if (redundant)
+	{
+		++state_command_counts.filtered;
+	}
+	else
+	{
+		++state_command_counts.emitted;
+	}
+
+	return redundant;
 }
 
 void CommandBuffer::flush_push_constants()
 {
-	if (stored_push_constants.empty())
+	// The next draw call appends push constants from the beginning of the block
+	push_constant_size = 0;
+
+	const PipelineLayout &pipeline_layout = pipeline_state.get_pipeline_layout();
+
+	// Push constants are not kept by pipeline layouts with different push constant ranges, so push them again
+	bool layout_changed = pipeline_layout.get_handle() != push_constant_layout;
+
+	if (layout_changed)
+	{
+		push_constant_layout = pipeline_layout.get_handle();
+
+		if (push_constant_written_end > 0)
+		{
+			push_constant_dirty_begin = 0;
+			push_constant_dirty_end   = push_constant_written_end;
+		}
+	}
+
+	if (push_constant_dirty_begin == push_constant_dirty_end)
 	{
 		return;
 	}
 
-	const PipelineLayout &pipeline_layout = pipeline_state.get_pipeline_layout();
+	const auto &push_constant_ranges = pipeline_layout.get_push_constant_ranges();
+
+	bool pushed{false};
+
+	// Split the changed bytes where the ranges of the shader stages begin or end,
+	// as each push must specify exactly the stages of the ranges it overlaps
+	uint32_t           segment_begin = push_constant_dirty_begin;
+	VkShaderStageFlags segment_stages{0};
+
+	for (uint32_t offset = push_constant_dirty_begin; offset < push_constant_dirty_end;)
+	{
+		uint32_t           next_offset = push_constant_dirty_end;
+		VkShaderStageFlags stages{0};
+
+		for (auto &push_constant_range : push_constant_ranges)
+		{
+			uint32_t range_end = push_constant_range.offset + push_constant_range.size;
+
+			if (offset >= push_constant_range.offset && offset < range_end)
+			{
+				stages |= push_constant_range.stageFlags;
+				next_offset = std::min(next_offset, range_end);
+			}
+			else if (offset < push_constant_range.offset)
+			{
+				next_offset = std::min(next_offset, push_constant_range.offset);
+			}
+		}
 
-	VkShaderStageFlags shader_stage = pipeline_layout.get_push_constant_range_stage(to_u32(stored_push_constants.size()));
+		if (stages != segment_stages)
+		{
+			if (segment_stages)
+			{
+				device_table.vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), segment_stages, segment_begin, offset - segment_begin, push_constant_data.data() + segment_begin);
+				pushed = true;
+			}
 
-	if (shader_stage)
+			segment_begin  = offset;
+			segment_stages = stages;
+		}
+
+		offset = next_offset;
+	}
+
+	if (segment_stages)
 	{
-		vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), shader_stage, 0, to_u32(stored_push_constants.size()), stored_push_constants.data());
+		device_table.vkCmdPushConstants(get_handle(), pipeline_layout.get_handle(), segment_stages, segment_begin, push_constant_dirty_end - segment_begin, push_constant_data.data() + segment_begin);
+		pushed = true;
 	}
-	else
+
+	if (!pushed && !layout_changed)
 	{
-		LOGW("Push constant range [{}, {}] not found", 0, stored_push_constants.size());
+		LOGW("Push constant range [{}, {}] not found", push_constant_dirty_begin, push_constant_dirty_end);
 	}
 
-	stored_push_constants.clear();
+	push_constant_dirty_begin = 0;
+	push_constant_dirty_end   = 0;
 }
 
 const CommandBuffer::State CommandBuffer::get_state() const
@@ -769,6 +1493,12 @@ void CommandBuffer::set_update_after_bind(bool update_after_bind_)
 	update_after_bind = update_after_bind_;
 }
 
+void CommandBuffer::set_async_pipeline_compilation(bool async_pipelines_, const GraphicsPipeline *fallback_pipeline_)
+{
+	async_pipelines   = async_pipelines_;
+	fallback_pipeline = fallback_pipeline_;
+}
+
 const CommandBuffer::RenderPassBinding &CommandBuffer::get_current_render_pass() const
 {
 	return current_render_pass;
@@ -790,23 +1520,23 @@ const bool CommandBuffer::is_render_size_optimal(const VkExtent2D &framebuffer_e
 
 void CommandBuffer::reset_query_pool(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count)
 {
-	vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
+	device_table.vkCmdResetQueryPool(get_handle(), query_pool.get_handle(), first_query, query_count);
 }
 
 void CommandBuffer::begin_query(const QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags)
 {
-	vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
+	device_table.vkCmdBeginQuery(get_handle(), query_pool.get_handle(), query, flags);
 }
 
 void CommandBuffer::end_query(const QueryPool &query_pool, uint32_t query)
 {
-	vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
+	device_table.vkCmdEndQuery(get_handle(), query_pool.get_handle(), query);
 }
 
 void CommandBuffer::write_timestamp(VkPipelineStageFlagBits pipeline_stage,
                                     const QueryPool &query_pool, uint32_t query)
 {
-	vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
+	device_table.vkCmdWriteTimestamp(get_handle(), pipeline_stage, query_pool.get_handle(), query);
 }
 
 VkResult CommandBuffer::reset(ResetMode reset_mode)
@@ -819,7 +1549,7 @@ VkResult CommandBuffer::reset(ResetMode reset_mode)
 
 	if (reset_mode == ResetMode::ResetIndividually)
 	{
-		result = vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
+		result = device_table.vkResetCommandBuffer(handle, VK_COMMAND_BUFFER_RESET_RELEASE_RESOURCES_BIT);
 	}
 
 	return result;
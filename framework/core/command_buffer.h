@@ -35,6 +35,7 @@ namespace vkb
 class CommandPool;
 class DescriptorSet;
 class Framebuffer;
+class GraphicsPipeline;
 class Pipeline;
 class PipelineLayout;
 class PipelineState;
@@ -74,6 +75,19 @@ class CommandBuffer
 		const Framebuffer *framebuffer;
 	};
 
+	/**
+	 * @brief Numbers of state setting commands recorded, and skipped because they would not change the state
+	 */
+	struct StateCommandCounts
+	{
+		uint64_t emitted{0};
+
+		uint64_t filtered{0};
+	};
+
+	/// Number of vertex buffer bindings, viewports and scissors tracked to skip redundant commands
+	static constexpr uint32_t MAX_TRACKED_BINDINGS = 16;
+
 	CommandBuffer(CommandPool &command_pool, VkCommandBufferLevel level);
 
 	CommandBuffer(const CommandBuffer &) = delete;
@@ -86,6 +100,11 @@ class CommandBuffer
 
 	CommandBuffer &operator=(CommandBuffer &&) = delete;
 
+	/**
+	 * @brief Gets the state command counts of all the command buffers ended since the last call, and resets them
+	 */
+	static StateCommandCounts reset_state_command_counts();
+
 	Device &get_device();
 
 	const VkCommandBuffer &get_handle() const;
@@ -95,8 +114,9 @@ class CommandBuffer
 	/**
 	 * @brief Flushes the command buffer, pushing the new changes
 	 * @param pipeline_bind_point The type of pipeline we want to flush
+	 * @return Whether a pipeline is bound, false if the pipeline is still being compiled asynchronously
 	 */
-	void flush(VkPipelineBindPoint pipeline_bind_point);
+	bool flush(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Sets the command buffer so that it is ready for recording
@@ -128,7 +148,12 @@ class CommandBuffer
 
 	void begin_render_pass(const RenderTarget &render_target, const RenderPass &render_pass, const Framebuffer &framebuffer, const std::vector<VkClearValue> &clear_values, VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
 
-	void next_subpass();
+	void next_subpass(VkSubpassContents contents = VK_SUBPASS_CONTENTS_INLINE);
+
+	/**
+	 * @return How the commands of the current subpass are provided, inline or by secondary command buffers
+	 */
+	VkSubpassContents get_current_subpass_contents() const;
 
 	void execute_commands(CommandBuffer &secondary_command_buffer);
 
@@ -136,6 +161,19 @@ class CommandBuffer
 
 	void end_render_pass();
 
+	/**
+	 * @brief Copies the pipeline state, the bound resources, the viewports and the scissors of a primary
+	 *        command buffer, so that a secondary command buffer recording commands for the current subpass
+	 *        draws with the state its primary set up. It must be called after begin
+	 * @param primary_cmd_buf The primary command buffer the secondary one is executed by
+	 */
+	void inherit_state(const CommandBuffer &primary_cmd_buf);
+
+	/**
+	 * @return A hash of the state copied by inherit_state, combined with the current render pass, framebuffer and subpass
+	 */
+	size_t get_state_hash() const;
+
 	void bind_pipeline_layout(PipelineLayout &pipeline_layout);
 
 	template <class T>
@@ -145,6 +183,7 @@ class CommandBuffer
 
 	/**
 	 * @brief Records byte data into the command buffer to be pushed as push constants to each draw call
+	 *        The data is appended after the data recorded since the last draw call
 	 * @param values The byte data to store
 	 */
 	void push_constants(const std::vector<uint8_t> &values);
@@ -152,17 +191,19 @@ class CommandBuffer
 	template <typename T>
 	void push_constants(const T &value)
 	{
-		auto data = to_bytes(value);
-
-		uint32_t size = to_u32(stored_push_constants.size() + data.size());
-
-		if (size > max_push_constants_size)
-		{
-			LOGE("Push constant limit exceeded ({} / {} bytes)", size, max_push_constants_size);
-			throw std::runtime_error("Cannot overflow push constant limit");
-		}
+		write_push_constants(push_constant_size, &value, to_u32(sizeof(T)));
+	}
 
-		stored_push_constants.insert(stored_push_constants.end(), data.begin(), data.end());
+	/**
+	 * @brief Records a value at an offset of the push constant block
+	 *        It is only pushed by the next draw call if it changed
+	 * @param offset The offset of the value in bytes
+	 * @param value The value to store
+	 */
+	template <typename T>
+	void push_constants(uint32_t offset, const T &value)
+	{
+		write_push_constants(offset, &value, to_u32(sizeof(T)));
 	}
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
@@ -237,6 +278,15 @@ class CommandBuffer
 
 	void set_update_after_bind(bool update_after_bind_);
 
+	/**
+	 * @brief Sets whether missing graphics pipelines are compiled in the background
+	 *        While a pipeline is not ready, draws are skipped or recorded with the fallback pipeline
+	 * @param async_pipelines_ Whether to compile missing graphics pipelines asynchronously
+	 * @param fallback_pipeline_ (optional) Pipeline used until the requested one is ready,
+	 *        it must be compatible with the pipeline layout of the draws using it
+	 */
+	void set_async_pipeline_compilation(bool async_pipelines_, const GraphicsPipeline *fallback_pipeline_ = nullptr);
+
 	void reset_query_pool(const QueryPool &query_pool, uint32_t first_query, uint32_t query_count);
 
 	void begin_query(const QueryPool &query_pool, uint32_t query, VkQueryControlFlags flags);
@@ -260,18 +310,38 @@ class CommandBuffer
 
 	CommandPool &command_pool;
 
+	/// Device-level functions of the device, recorded directly into the driver without the loader dispatch
+	const VolkDeviceTable &device_table;
+
 	VkCommandBuffer handle{VK_NULL_HANDLE};
 
-	RenderPassBinding current_render_pass;
+	RenderPassBinding current_render_pass{};
+
+	VkSubpassContents current_subpass_contents{VK_SUBPASS_CONTENTS_INLINE};
 
 	PipelineState pipeline_state;
 
 	ResourceBindingState resource_binding_state;
 
-	std::vector<uint8_t> stored_push_constants;
-
 	uint32_t max_push_constants_size;
 
+	// Push constant block, allocated once with the size limit of the device
+	std::vector<uint8_t> push_constant_data;
+
+	// Offset at which push_constants appends data, reset by each draw call
+	uint32_t push_constant_size{0};
+
+	// End of the bytes written to the push constant block since recording began
+	uint32_t push_constant_written_end{0};
+
+	// Range of bytes changed since they were last pushed
+	uint32_t push_constant_dirty_begin{0};
+
+	uint32_t push_constant_dirty_end{0};
+
+	// Pipeline layout the push constants were last pushed with
+	VkPipelineLayout push_constant_layout{VK_NULL_HANDLE};
+
 	VkExtent2D last_framebuffer_extent{};
 
 	VkExtent2D last_render_area_extent{};
@@ -280,7 +350,75 @@ class CommandBuffer
 	// that contain update after bind, as they wont be implicitly updated
 	bool update_after_bind{false};
 
-	std::unordered_map<uint32_t, DescriptorSetLayout *> descriptor_set_layout_binding_state;
+	// If true, graphics pipelines are requested without waiting for them to be compiled
+	bool async_pipelines{false};
+
+	const GraphicsPipeline *fallback_pipeline{nullptr};
+
+	std::array<DescriptorSetLayout *, ResourceBindingState::MAX_SETS> descriptor_set_layout_binding_state{};
+
+	/// Scratch storage reused by every descriptor state flush, so that it does not allocate once grown
+	std::vector<uint32_t> dynamic_offsets;
+
+	std::vector<uint32_t> bindings_to_update;
+
+	std::vector<DescriptorUpdateInfo> push_descriptor_infos;
+
+	std::vector<VkWriteDescriptorSet> push_descriptor_writes;
+
+	/**
+	 * @brief Vertex and index buffers and dynamic state last recorded, to skip commands which would not change them
+	 *        All graphics pipelines are created with the same dynamic states, so binding a pipeline does not invalidate them
+	 */
+	struct RecordedState
+	{
+		std::array<VkBuffer, MAX_TRACKED_BINDINGS> vertex_buffers{};
+
+		std::array<VkDeviceSize, MAX_TRACKED_BINDINGS> vertex_buffer_offsets{};
+
+		uint32_t vertex_buffer_mask{0};
+
+		VkBuffer index_buffer{VK_NULL_HANDLE};
+
+		VkDeviceSize index_buffer_offset{0};
+
+		VkIndexType index_type{VK_INDEX_TYPE_UINT16};
+
+		std::array<VkViewport, MAX_TRACKED_BINDINGS> viewports{};
+
+		uint32_t viewport_mask{0};
+
+		std::array<VkRect2D, MAX_TRACKED_BINDINGS> scissors{};
+
+		uint32_t scissor_mask{0};
+
+		bool has_line_width{false};
+
+		float line_width{0.0f};
+
+		bool has_depth_bias{false};
+
+		std::array<float, 3> depth_bias{};
+
+		bool has_blend_constants{false};
+
+		std::array<float, 4> blend_constants{};
+
+		bool has_depth_bounds{false};
+
+		std::array<float, 2> depth_bounds{};
+	};
+
+	RecordedState recorded_state;
+
+	StateCommandCounts state_command_counts;
+
+	/**
+	 * @brief Counts a state command
+	 * @param redundant Whether the command would not change the recorded state
+	 * @return Whether to skip the command
+	 */
+	bool skip_state_command(bool redundant);
 
 	const RenderPassBinding &get_current_render_pass() const;
 
@@ -293,18 +431,46 @@ class CommandBuffer
 
 	/**
 	 * @brief Flush the piplines state
+	 * @return Whether a pipeline is bound for the next command
 	 */
-	void flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
+	bool flush_pipeline_state(VkPipelineBindPoint pipeline_bind_point);
 
 	/**
 	 * @brief Flush the descriptor set state
 	 */
 	void flush_descriptor_state(VkPipelineBindPoint pipeline_bind_point);
 
+	/**
+	 * @brief Gathers the buffer infos and image infos of the resources bound to a set, to write a new descriptor set
+	 */
+	void get_binding_infos(const ResourceSet &resource_set, DescriptorSetLayout &descriptor_set_layout, BindingMap<VkDescriptorBufferInfo> &buffer_infos, BindingMap<VkDescriptorImageInfo> &image_infos);
+
+	/**
+	 * @brief Checks that a descriptor set holds the descriptors of the resources bound to a set, without allocating memory
+	 *        Guards against collisions of the hash used as the key of the descriptor set
+	 */
+	bool matches_binding_infos(const ResourceSet &resource_set, DescriptorSetLayout &descriptor_set_layout, DescriptorSet &descriptor_set);
+
+	/**
+	 * @brief Gets the descriptor of a bound resource, in the form expected by a binding
+	 * @return False if the resource cannot be written to the binding
+	 */
+	bool get_descriptor_info(const ResourceInfo &resource_info, const VkDescriptorSetLayoutBinding &binding_info, DescriptorUpdateInfo &descriptor_info);
+
+	/**
+	 * @brief Pushes the resources bound to a set into the command buffer, for a push descriptor set layout
+	 */
+	void push_descriptor_set(VkPipelineBindPoint pipeline_bind_point, const PipelineLayout &pipeline_layout, const DescriptorSetLayout &descriptor_set_layout, const ResourceSet &resource_set);
+
 	/**
 	 * @brief Flush the push constant state
 	 */
 	void flush_push_constants();
+
+	/**
+	 * @brief Copies data to the push constant block, and adds it to the bytes to push if it changed
+	 */
+	void write_push_constants(uint32_t offset, const void *data, uint32_t size);
 };
 
 template <class T>
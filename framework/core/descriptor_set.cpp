@@ -53,6 +53,7 @@ void DescriptorSet::reset(const BindingMap<VkDescriptorBufferInfo> &new_buffer_i
 	}
 
 	this->write_descriptor_sets.clear();
+	this->update_template_payload.clear();
 	this->updated_bindings.clear();
 
 	prepare();
@@ -147,6 +148,48 @@ void DescriptorSet::prepare()
 			LOGE("Shader layout set does not use image binding at #{}", binding_index);
 		}
 	}
+
+	prepare_update_template_payload();
+}
+
+void DescriptorSet::prepare_update_template_payload()
+{
+	update_template_payload.clear();
+
+	if (descriptor_set_layout.get_update_template() == VK_NULL_HANDLE ||
+	    write_descriptor_sets.size() != descriptor_set_layout.get_update_template_size())
+	{
+		return;
+	}
+
+	update_template_payload.resize(write_descriptor_sets.size());
+
+	std::vector<bool> written(update_template_payload.size(), false);
+
+	for (auto &write_descriptor_set : write_descriptor_sets)
+	{
+		auto binding_info = descriptor_set_layout.find_layout_binding(write_descriptor_set.dstBinding);
+
+		uint32_t index = descriptor_set_layout.get_update_template_offset(write_descriptor_set.dstBinding) + write_descriptor_set.dstArrayElement;
+
+		// Partially written sets are updated with the write operations instead
+		if (write_descriptor_set.dstArrayElement >= binding_info->descriptorCount || written[index])
+		{
+			update_template_payload.clear();
+			return;
+		}
+
+		if (write_descriptor_set.pBufferInfo)
+		{
+			update_template_payload[index].buffer = *write_descriptor_set.pBufferInfo;
+		}
+		else
+		{
+			update_template_payload[index].image = *write_descriptor_set.pImageInfo;
+		}
+
+		written[index] = true;
+	}
 }
 
 void DescriptorSet::update(const std::vector<uint32_t> &bindings_to_update)
@@ -196,8 +239,16 @@ void DescriptorSet::update(const std::vector<uint32_t> &bindings_to_update)
 		}
 	}
 
+	// Write all the descriptors at once with the update template of the layout if possible
+	if (!update_template_payload.empty() && write_operations.size() == write_descriptor_sets.size())
+	{
+		vkUpdateDescriptorSetWithTemplateKHR(device.get_handle(),
+		                                     handle,
+		                                     descriptor_set_layout.get_update_template(),
+		                                     update_template_payload.data());
+	}
 	// Perform the Vulkan call to update the DescriptorSet by executing the write operations
-	if (!write_operations.empty())
+	else if (!write_operations.empty())
 	{
 		vkUpdateDescriptorSets(device.get_handle(),
 		                       to_u32(write_operations.size()),
@@ -222,6 +273,7 @@ DescriptorSet::DescriptorSet(DescriptorSet &&other) :
     image_infos{std::move(other.image_infos)},
     handle{other.handle},
     write_descriptor_sets{std::move(other.write_descriptor_sets)},
+    update_template_payload{std::move(other.update_template_payload)},
     updated_bindings{std::move(other.updated_bindings)}
 {
 	other.handle = VK_NULL_HANDLE;
@@ -232,6 +284,11 @@ VkDescriptorSet DescriptorSet::get_handle() const
 	return handle;
 }
 
+DescriptorPool &DescriptorSet::get_descriptor_pool()
+{
+	return descriptor_pool;
+}
+
 const DescriptorSetLayout &DescriptorSet::get_layout() const
 {
 	return descriptor_set_layout;
@@ -19,11 +19,11 @@
 
 #include "common/helpers.h"
 #include "common/vk_common.h"
+#include "core/descriptor_set_layout.h"
 
 namespace vkb
 {
 class Device;
-class DescriptorSetLayout;
 class DescriptorPool;
 
 /**
@@ -76,10 +76,19 @@ class DescriptorSet
 	 */
 	void update(const std::vector<uint32_t> &bindings_to_update = {});
 
+	/**
+	 * @brief Packs the write operations into a payload for the update template of the layout,
+	 *        if they write every descriptor of the layout exactly once
+	 *        Must be called again after modifying the infos returned by get_buffer_infos or get_image_infos
+	 */
+	void prepare_update_template_payload();
+
 	const DescriptorSetLayout &get_layout() const;
 
 	VkDescriptorSet get_handle() const;
 
+	DescriptorPool &get_descriptor_pool();
+
 	BindingMap<VkDescriptorBufferInfo> &get_buffer_infos();
 
 	BindingMap<VkDescriptorImageInfo> &get_image_infos();
@@ -107,6 +116,9 @@ class DescriptorSet
 	// The list of write operations for the descriptor set
 	std::vector<VkWriteDescriptorSet> write_descriptor_sets;
 
+	// The descriptors packed for the update template of the layout, empty if the write operations do not cover all of its descriptors
+	std::vector<DescriptorUpdateInfo> update_template_payload;
+
 	// The bindings of the write descriptors that have had vkUpdateDescriptorSets since the last call to update().
 	// Each binding number is mapped to a hash of the binding description that it will be updated to.
 	std::unordered_map<uint32_t, size_t> updated_bindings;
@@ -179,6 +179,42 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 		create_info.flags |= std::find(binding_flags.begin(), binding_flags.end(), VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT_EXT) != binding_flags.end() ? VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT : 0;
 	}
 
+	// Handle push descriptors, used for the whole set if one of its resources asks for it
+	if (std::find_if(resource_set.begin(), resource_set.end(),
+	                 [](const ShaderResource &shader_resource) { return shader_resource.mode == ShaderResourceMode::PushDescriptor; }) != resource_set.end())
+	{
+		uint32_t descriptor_count{0};
+
+		for (auto &binding : bindings)
+		{
+			descriptor_count += binding.descriptorCount;
+		}
+
+		if (!device.is_enabled(VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME))
+		{
+			LOGW("Set {} uses push descriptors, but {} is not enabled. Allocating descriptor sets instead.", set_index, VK_KHR_PUSH_DESCRIPTOR_EXTENSION_NAME);
+		}
+		else if (descriptor_count > MAX_PUSH_DESCRIPTORS)
+		{
+			LOGW("Set {} uses push descriptors, but has {} descriptors which exceeds the guaranteed limit of {}. Allocating descriptor sets instead.", set_index, descriptor_count, MAX_PUSH_DESCRIPTORS);
+		}
+		else if (create_info.flags & VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT_EXT)
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, push descriptors are not allowed if at least one resource is update-after-bind.");
+		}
+		else if (std::find_if(bindings.begin(), bindings.end(),
+		                      [](const VkDescriptorSetLayoutBinding &binding) { return is_dynamic_buffer_descriptor_type(binding.descriptorType); }) != bindings.end())
+		{
+			throw std::runtime_error("Cannot create descriptor set layout, dynamic resources are not allowed in a push descriptor set.");
+		}
+		else
+		{
+			create_info.flags |= VK_DESCRIPTOR_SET_LAYOUT_CREATE_PUSH_DESCRIPTOR_BIT_KHR;
+
+			push_descriptor = true;
+		}
+	}
+
 	// Create the Vulkan descriptor set layout handle
 	VkResult result = vkCreateDescriptorSetLayout(device.get_handle(), &create_info, nullptr, &handle);
 
@@ -186,6 +222,12 @@ DescriptorSetLayout::DescriptorSetLayout(Device &                           devi
 	{
 		throw VulkanException{result, "Cannot create DescriptorSetLayout"};
 	}
+
+	// Push descriptor sets are not allocated, so they are not written with a descriptor set update template
+	if (device.is_enabled(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME) && !bindings.empty() && !push_descriptor)
+	{
+		create_update_template();
+	}
 }
 
 DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
@@ -197,13 +239,23 @@ DescriptorSetLayout::DescriptorSetLayout(DescriptorSetLayout &&other) :
     binding_flags{std::move(other.binding_flags)},
     bindings_lookup{std::move(other.bindings_lookup)},
     binding_flags_lookup{std::move(other.binding_flags_lookup)},
-    resources_lookup{std::move(other.resources_lookup)}
+    resources_lookup{std::move(other.resources_lookup)},
+    update_template{other.update_template},
+    update_template_size{other.update_template_size},
+    update_template_offsets{std::move(other.update_template_offsets)},
+    push_descriptor{other.push_descriptor}
 {
-	other.handle = VK_NULL_HANDLE;
+	other.handle          = VK_NULL_HANDLE;
+	other.update_template = VK_NULL_HANDLE;
 }
 
 DescriptorSetLayout::~DescriptorSetLayout()
 {
+	if (update_template != VK_NULL_HANDLE)
+	{
+		vkDestroyDescriptorUpdateTemplateKHR(device.get_handle(), update_template, nullptr);
+	}
+
 	// Destroy descriptor set layout
 	if (handle != VK_NULL_HANDLE)
 	{
@@ -255,6 +307,18 @@ std::unique_ptr<VkDescriptorSetLayoutBinding> DescriptorSetLayout::get_layout_bi
 	return get_layout_binding(it->second);
 }
 
+const VkDescriptorSetLayoutBinding *DescriptorSetLayout::find_layout_binding(const uint32_t binding_index) const
+{
+	auto it = bindings_lookup.find(binding_index);
+
+	if (it == bindings_lookup.end())
+	{
+		return nullptr;
+	}
+
+	return &it->second;
+}
+
 VkDescriptorBindingFlagsEXT DescriptorSetLayout::get_layout_binding_flag(const uint32_t binding_index) const
 {
 	auto it = binding_flags_lookup.find(binding_index);
@@ -272,4 +336,68 @@ const std::vector<ShaderModule *> &DescriptorSetLayout::get_shader_modules() con
 	return shader_modules;
 }
 
+bool DescriptorSetLayout::is_push_descriptor() const
+{
+	return push_descriptor;
+}
+
+VkDescriptorUpdateTemplateKHR DescriptorSetLayout::get_update_template() const
+{
+	return update_template;
+}
+
+uint32_t DescriptorSetLayout::get_update_template_size() const
+{
+	return update_template_size;
+}
+
+uint32_t DescriptorSetLayout::get_update_template_offset(const uint32_t binding_index) const
+{
+	auto it = update_template_offsets.find(binding_index);
+
+	if (it == update_template_offsets.end())
+	{
+		throw std::runtime_error("Binding " + std::to_string(binding_index) + " is not part of the update template");
+	}
+
+	return it->second;
+}
+
+void DescriptorSetLayout::create_update_template()
+{
+	std::vector<VkDescriptorUpdateTemplateEntryKHR> entries;
+	entries.reserve(bindings.size());
+
+	for (auto &binding : bindings)
+	{
+		VkDescriptorUpdateTemplateEntryKHR entry{};
+
+		entry.dstBinding      = binding.binding;
+		entry.dstArrayElement = 0;
+		entry.descriptorCount = binding.descriptorCount;
+		entry.descriptorType  = binding.descriptorType;
+		entry.offset          = update_template_size * sizeof(DescriptorUpdateInfo);
+		entry.stride          = sizeof(DescriptorUpdateInfo);
+
+		entries.push_back(entry);
+
+		update_template_offsets.emplace(binding.binding, update_template_size);
+
+		update_template_size += binding.descriptorCount;
+	}
+
+	VkDescriptorUpdateTemplateCreateInfoKHR create_info{VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO_KHR};
+	create_info.descriptorUpdateEntryCount = to_u32(entries.size());
+	create_info.pDescriptorUpdateEntries   = entries.data();
+	create_info.templateType               = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET_KHR;
+	create_info.descriptorSetLayout        = handle;
+
+	VkResult result = vkCreateDescriptorUpdateTemplateKHR(device.get_handle(), &create_info, nullptr, &update_template);
+
+	if (result != VK_SUCCESS)
+	{
+		throw VulkanException{result, "Cannot create descriptor update template"};
+	}
+}
+
 }        // namespace vkb
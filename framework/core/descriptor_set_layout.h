@@ -28,6 +28,16 @@ class ShaderModule;
 
 struct ShaderResource;
 
+/**
+ * @brief A descriptor in the payload written to a descriptor set with the update template of its layout
+ */
+union DescriptorUpdateInfo
+{
+	VkDescriptorBufferInfo buffer;
+
+	VkDescriptorImageInfo image;
+};
+
 /**
  * @brief Caches DescriptorSet objects for the shader's set index.
  *        Creates a DescriptorPool to allocate the DescriptorSet objects
@@ -35,6 +45,9 @@ struct ShaderResource;
 class DescriptorSetLayout
 {
   public:
+	/// Number of descriptors a push descriptor set can have on any device supporting VK_KHR_push_descriptor
+	static constexpr uint32_t MAX_PUSH_DESCRIPTORS = 32;
+
 	/**
 	 * @brief Creates a descriptor set layout from a set of resources
 	 * @param device A valid Vulkan device
@@ -67,12 +80,40 @@ class DescriptorSetLayout
 
 	std::unique_ptr<VkDescriptorSetLayoutBinding> get_layout_binding(const std::string &name) const;
 
+	/**
+	 * @brief Looks up a binding without copying it, for code recording draws
+	 * @return The layout binding, or nullptr if the layout does not have it
+	 */
+	const VkDescriptorSetLayoutBinding *find_layout_binding(const uint32_t binding_index) const;
+
 	const std::vector<VkDescriptorBindingFlagsEXT> &get_binding_flags() const;
 
 	VkDescriptorBindingFlagsEXT get_layout_binding_flag(const uint32_t binding_index) const;
 
 	const std::vector<ShaderModule *> &get_shader_modules() const;
 
+	/**
+	 * @return Whether the descriptors of this set are pushed into command buffers rather than written to descriptor sets
+	 */
+	bool is_push_descriptor() const;
+
+	/**
+	 * @return The update template writing all the descriptors of the layout,
+	 *         or VK_NULL_HANDLE if VK_KHR_descriptor_update_template is not enabled
+	 */
+	VkDescriptorUpdateTemplateKHR get_update_template() const;
+
+	/**
+	 * @return The number of descriptors written by the update template
+	 */
+	uint32_t get_update_template_size() const;
+
+	/**
+	 * @brief Gets the index in the update template payload of the first descriptor of a binding
+	 *        The array elements of the binding follow it
+	 */
+	uint32_t get_update_template_offset(const uint32_t binding_index) const;
+
   private:
 	Device &device;
 
@@ -91,5 +132,18 @@ class DescriptorSetLayout
 	std::unordered_map<std::string, uint32_t> resources_lookup;
 
 	std::vector<ShaderModule *> shader_modules;
+
+	VkDescriptorUpdateTemplateKHR update_template{VK_NULL_HANDLE};
+
+	uint32_t update_template_size{0};
+
+	std::unordered_map<uint32_t, uint32_t> update_template_offsets;
+
+	bool push_descriptor{false};
+
+	/**
+	 * @brief Creates an update template with an entry for each binding, reading a tightly packed array of DescriptorUpdateInfo
+	 */
+	void create_update_template();
 };
 }        // namespace vkb
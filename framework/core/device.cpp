@@ -23,8 +23,43 @@ VKBP_DISABLE_WARNINGS()
 #include <vk_mem_alloc.h>
 VKBP_ENABLE_WARNINGS()
 
+#include <mutex>
+
 namespace vkb
 {
+namespace
+{
+/// Number of live devices, guarded by device_count_mutex
+uint32_t device_count{0};
+
+std::mutex device_count_mutex;
+
+/**
+ * @brief Gives back the count of a device whose constructor throws, as its destructor does not run
+ */
+class DeviceCountGuard
+{
+  public:
+	~DeviceCountGuard()
+	{
+		if (!released)
+		{
+			std::lock_guard<std::mutex> guard{device_count_mutex};
+			--device_count;
+		}
+	}
+
+	/// @brief Keeps the count once the device is fully constructed
+	void release()
+	{
+		released = true;
+	}
+
+  private:
+	bool released{false};
+};
+}        // namespace
+
 Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<const char *, bool> requested_extensions) :
     gpu{gpu},
     resource_cache{*this}
@@ -112,11 +147,24 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		}
 	}
 
+	// Descriptor sets are written with update templates when available
+	if (is_extension_supported(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME))
+	{
+		enabled_extensions.push_back(VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME);
+
+		LOGI("Descriptor update templates enabled");
+	}
+
 	// Check that extensions are supported before trying to create the device
 	std::vector<const char *> unsupported_extensions{};
 	for (auto &extension : requested_extensions)
 	{
-		if (is_extension_supported(extension.first))
+		if (is_enabled(extension.first))
+		{
+			// Already enabled by the framework
+			continue;
+		}
+		else if (is_extension_supported(extension.first))
 		{
 			enabled_extensions.emplace_back(extension.first);
 		}
@@ -178,6 +226,26 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 		throw VulkanException{result, "Cannot create device"};
 	}
 
+	// Load the device functions from the driver, so that they skip the loader trampoline and dispatch
+	volkLoadDeviceTable(&table, handle);
+
+	{
+		std::lock_guard<std::mutex> guard{device_count_mutex};
+
+		// The global functions can only be loaded for a single device, with several devices
+		// they are reset to the loader functions which dispatch to the right device
+		if (++device_count == 1)
+		{
+			volkLoadDevice(handle);
+		}
+		else
+		{
+			volkLoadInstance(gpu.get_instance().get_handle());
+		}
+	}
+
+	DeviceCountGuard device_count_guard;
+
 	queues.resize(queue_family_properties_count);
 
 	for (uint32_t queue_family_index = 0U; queue_family_index < queue_family_properties_count; ++queue_family_index)
@@ -239,6 +307,8 @@ Device::Device(PhysicalDevice &gpu, VkSurfaceKHR surface, std::unordered_map<con
 
 	command_pool = std::make_unique<CommandPool>(*this, get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT, 0).get_family_index());
 	fence_pool   = std::make_unique<FencePool>(*this);
+
+	device_count_guard.release();
 }
 
 Device::~Device()
@@ -261,6 +331,9 @@ Device::~Device()
 	if (handle != VK_NULL_HANDLE)
 	{
 		vkDestroyDevice(handle, nullptr);
+
+		std::lock_guard<std::mutex> guard{device_count_mutex};
+		--device_count;
 	}
 }
 
@@ -287,6 +360,11 @@ VkDevice Device::get_handle() const
 	return handle;
 }
 
+const VolkDeviceTable &Device::get_table() const
+{
+	return table;
+}
+
 VmaAllocator Device::get_memory_allocator() const
 {
 	return memory_allocator;
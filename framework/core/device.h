@@ -74,6 +74,13 @@ class Device
 
 	VkDevice get_handle() const;
 
+	/**
+	 * @brief Gets the device-level functions of this device, loaded directly from its driver
+	 *        The global Vulkan functions are loaded the same way while this is the only device,
+	 *        and go through the loader dispatch when several devices coexist
+	 */
+	const VolkDeviceTable &get_table() const;
+
 	VmaAllocator get_memory_allocator() const;
 
 	/**
@@ -187,6 +194,8 @@ class Device
 
 	VkDevice handle{VK_NULL_HANDLE};
 
+	VolkDeviceTable table{};
+
 	std::vector<VkExtensionProperties> device_extensions;
 
 	std::vector<const char *> enabled_extensions{};
@@ -84,6 +84,13 @@ PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *>
 		descriptor_set_layouts.emplace_back(&device.get_resource_cache().request_descriptor_set_layout(shader_set_it.first, shader_modules, shader_set_it.second));
 	}
 
+	// Vulkan allows a single push descriptor set per pipeline layout
+	if (std::count_if(descriptor_set_layouts.begin(), descriptor_set_layouts.end(),
+	                  [](const DescriptorSetLayout *descriptor_set_layout) { return descriptor_set_layout && descriptor_set_layout->is_push_descriptor(); }) > 1)
+	{
+		throw std::runtime_error("Cannot create pipeline layout, only one of its sets can use push descriptors.");
+	}
+
 	// Collect all the descriptor set layout handles, maintaining set order
 	std::vector<VkDescriptorSetLayout> descriptor_set_layout_handles;
 	for (uint32_t i = 0; i < descriptor_set_layouts.size(); ++i)
@@ -99,7 +106,6 @@ PipelineLayout::PipelineLayout(Device &device, const std::vector<ShaderModule *>
 	}
 
 	// Collect all the push constant shader resources
-	std::vector<VkPushConstantRange> push_constant_ranges;
 	for (auto &push_constant_resource : get_resources(ShaderResourceType::PushConstant))
 	{
 		push_constant_ranges.push_back({push_constant_resource.stages, push_constant_resource.offset, push_constant_resource.size});
@@ -127,7 +133,8 @@ PipelineLayout::PipelineLayout(PipelineLayout &&other) :
     shader_modules{std::move(other.shader_modules)},
     shader_resources{std::move(other.shader_resources)},
     shader_sets{std::move(other.shader_sets)},
-    descriptor_set_layouts{std::move(other.descriptor_set_layouts)}
+    descriptor_set_layouts{std::move(other.descriptor_set_layouts)},
+    push_constant_ranges{std::move(other.push_constant_ranges)}
 {
 	other.handle = VK_NULL_HANDLE;
 }
@@ -206,4 +213,9 @@ VkShaderStageFlags PipelineLayout::get_push_constant_range_stage(uint32_t size,
 	}
 	return stages;
 }
+
+const std::vector<VkPushConstantRange> &PipelineLayout::get_push_constant_ranges() const
+{
+	return push_constant_ranges;
+}
 }        // namespace vkb
@@ -57,6 +57,8 @@ class PipelineLayout
 
 	VkShaderStageFlags get_push_constant_range_stage(uint32_t size, uint32_t offset = 0) const;
 
+	const std::vector<VkPushConstantRange> &get_push_constant_ranges() const;
+
   private:
 	Device &device;
 
@@ -73,5 +75,8 @@ class PipelineLayout
 
 	// The different descriptor set layouts for this pipeline layout
 	std::vector<DescriptorSetLayout *> descriptor_set_layouts;
+
+	// The push constant ranges of each shader stage
+	std::vector<VkPushConstantRange> push_constant_ranges;
 };
 }        // namespace vkb
@@ -17,20 +17,24 @@
 
 #include "shader_module.h"
 
+#include <mutex>
+
 #include "common/logging.h"
 #include "device.h"
 #include "glsl_compiler.h"
 #include "platform/filesystem.h"
 #include "spirv_reflection.h"
+#include "timer.h"
 
 namespace vkb
 {
 /**
  * @brief Pre-compiles project shader files to include header code
  * @param filename The shader file
+ * @param includes Filled with the paths of the included files, if not null
  * @returns A byte array of the final shader
  */
-inline std::vector<std::string> precompile_shader(const std::string &source)
+inline std::vector<std::string> precompile_shader(const std::string &source, std::set<std::string> *includes)
 {
 	std::vector<std::string> final_file;
 
@@ -48,7 +52,12 @@ inline std::vector<std::string> precompile_shader(const std::string &source)
 				include_path = include_path.substr(0, last_quote);
 			}
 
-			auto include_file = precompile_shader(fs::read_shader(include_path));
+			if (includes)
+			{
+				includes->insert(include_path);
+			}
+
+			auto include_file = precompile_shader(fs::read_shader(include_path), includes);
 			for (auto &include_file_line : include_file)
 			{
 				final_file.push_back(include_file_line);
@@ -77,10 +86,70 @@ inline std::vector<uint8_t> convert_to_bytes(std::vector<std::string> &lines)
 	return bytes;
 }
 
+namespace
+{
+/// Live shader sources loaded from a file, see ShaderSource::reload
+std::set<ShaderSource *> tracked_sources;
+
+std::mutex tracked_sources_mutex;
+
+/// Definitions of the flags of all the shader variants, as glslang processes
+struct ShaderVariantFlagRegistry
+{
+	std::mutex mutex;
+
+	std::vector<std::string> processes;
+
+	std::unordered_map<std::string, uint32_t> flags;
+};
+
+ShaderVariantFlagRegistry &get_flag_registry()
+{
+	static ShaderVariantFlagRegistry registry;
+	return registry;
+}
+
+uint32_t register_flag(const std::string &process)
+{
+	auto &registry = get_flag_registry();
+
+	std::lock_guard<std::mutex> guard{registry.mutex};
+
+	auto flag_it = registry.flags.find(process);
+
+	if (flag_it != registry.flags.end())
+	{
+		return flag_it->second;
+	}
+
+	if (registry.processes.size() >= ShaderVariant::MAX_FLAG_COUNT)
+	{
+		throw std::runtime_error("Too many shader variant definitions, increase ShaderVariant::MAX_FLAG_COUNT");
+	}
+
+	auto flag = static_cast<uint32_t>(registry.processes.size());
+
+	registry.processes.push_back(process);
+	registry.flags.emplace(process, flag);
+
+	return flag;
+}
+}        // namespace
+
+std::vector<uint8_t> expand_shader_includes(const std::string &source, std::set<std::string> *includes)
+{
+	// Precompile source into the final spirv bytecode
+	auto glsl_final_source = precompile_shader(source, includes);
+
+	return convert_to_bytes(glsl_final_source);
+}
+
 ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant) :
     device{device},
     stage{stage},
-    entry_point{entry_point}
+    entry_point{entry_point},
+    source_filename{glsl_source.get_filename()},
+    shader_variant{shader_variant}
 {
 	// Compiling from GLSL source requires the entry point
 	if (entry_point.empty())
@@ -96,27 +165,51 @@ ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const Sh
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
-	// Precompile source into the final spirv bytecode
-	auto glsl_final_source = precompile_shader(source);
-
 	// Compile the GLSL source
 	GLSLCompiler glsl_compiler;
 
-	if (!glsl_compiler.compile_to_spirv(stage, convert_to_bytes(glsl_final_source), entry_point, shader_variant, spirv, info_log))
+	if (!glsl_compiler.compile_to_spirv(stage, expand_shader_includes(source, &source_includes), entry_point, shader_variant, spirv, info_log))
 	{
 		LOGE("Shader compilation failed for shader \"{}\"", glsl_source.get_filename());
 		LOGE("{}", info_log);
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
+	reflect(glsl_source.get_filename(), shader_variant);
+}
+
+ShaderModule::ShaderModule(Device &device, VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, const std::string &entry_point, const ShaderVariant &shader_variant) :
+    device{device},
+    stage{stage},
+    entry_point{entry_point},
+    spirv{spirv},
+    shader_variant{shader_variant}
+{
+	if (entry_point.empty() || spirv.empty())
+	{
+		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
+	}
+
+	reflect("precompiled", shader_variant);
+}
+
+void ShaderModule::reflect(const std::string &name, const ShaderVariant &shader_variant)
+{
 	SPIRVReflection spirv_reflection;
 
+	Timer timer;
+	timer.start();
+
 	// Reflect all shader resouces
 	if (!spirv_reflection.reflect_shader_resources(stage, spirv, resources, shader_variant))
 	{
 		throw VulkanException{VK_ERROR_INITIALIZATION_FAILED};
 	}
 
+	reflection_time = timer.stop<Timer::Milliseconds>();
+
+	LOGD("Reflected shader \"{}\" in {} ms", name, vkb::to_string(reflection_time));
+
 	// Generate a unique id, determined by source and variant
 	std::hash<std::string> hasher{};
 	id = hasher(std::string{reinterpret_cast<const char *>(spirv.data()),
@@ -130,7 +223,11 @@ ShaderModule::ShaderModule(ShaderModule &&other) :
     entry_point{other.entry_point},
     spirv{other.spirv},
     resources{other.resources},
-    info_log{other.info_log}
+    info_log{other.info_log},
+    reflection_time{other.reflection_time},
+    source_filename{other.source_filename},
+    source_includes{other.source_includes},
+    shader_variant{other.shader_variant}
 {
 	other.stage = {};
 }
@@ -165,6 +262,26 @@ const std::vector<uint32_t> &ShaderModule::get_binary() const
 	return spirv;
 }
 
+const std::string &ShaderModule::get_source_filename() const
+{
+	return source_filename;
+}
+
+const std::set<std::string> &ShaderModule::get_source_includes() const
+{
+	return source_includes;
+}
+
+const ShaderVariant &ShaderModule::get_shader_variant() const
+{
+	return shader_variant;
+}
+
+double ShaderModule::get_reflection_time() const
+{
+	return reflection_time;
+}
+
 void ShaderModule::set_resource_mode(const std::string &resource_name, const ShaderResourceMode &resource_mode)
 {
 	auto it = std::find_if(resources.begin(), resources.end(), [&resource_name](const ShaderResource &resource) { return resource.name == resource_name; });
@@ -193,16 +310,39 @@ void ShaderModule::set_resource_mode(const std::string &resource_name, const Sha
 	}
 }
 
-ShaderVariant::ShaderVariant(std::string &&preamble, std::vector<std::string> &&processes) :
-    preamble{std::move(preamble)},
-    processes{std::move(processes)}
+ShaderVariant::ShaderVariant(const std::vector<std::string> &processes)
 {
-	update_id();
+	for (auto &process : processes)
+	{
+		if (process.size() < 2)
+		{
+			continue;
+		}
+
+		if (process[0] == 'D')
+		{
+			add_define(process.substr(1));
+		}
+		else if (process[0] == 'U')
+		{
+			add_undefine(process.substr(1));
+		}
+	}
+}
+
+uint32_t ShaderVariant::register_define(const std::string &def)
+{
+	return register_flag("D" + def);
+}
+
+uint32_t ShaderVariant::register_undefine(const std::string &undef)
+{
+	return register_flag("U" + undef);
 }
 
 size_t ShaderVariant::get_id() const
 {
-	return id;
+	return std::hash<Flags>{}(flags);
 }
 
 void ShaderVariant::add_definitions(const std::vector<std::string> &definitions)
@@ -215,29 +355,31 @@ void ShaderVariant::add_definitions(const std::vector<std::string> &definitions)
 
 void ShaderVariant::add_define(const std::string &def)
 {
-	processes.push_back("D" + def);
+	add_flag(register_define(def));
+}
 
-	std::string tmp_def = def;
+void ShaderVariant::add_undefine(const std::string &undef)
+{
+	add_flag(register_undefine(undef));
+}
 
-	// The "=" needs to turn into a space
-	size_t pos_equal = tmp_def.find_first_of("=");
-	if (pos_equal != std::string::npos)
+void ShaderVariant::add_flag(uint32_t flag)
+{
+	if (!flags.test(flag))
 	{
-		tmp_def[pos_equal] = ' ';
+		flags.set(flag);
+		ordered_flags.push_back(flag);
 	}
-
-	preamble.append("#define " + tmp_def + "\n");
-
-	update_id();
 }
 
-void ShaderVariant::add_undefine(const std::string &undef)
+bool ShaderVariant::has_flag(uint32_t flag) const
 {
-	processes.push_back("U" + undef);
-
-	preamble.append("#undef " + undef + "\n");
+	return flags.test(flag);
+}
 
-	update_id();
+const ShaderVariant::Flags &ShaderVariant::get_flags() const
+{
+	return flags;
 }
 
 void ShaderVariant::add_runtime_array_size(const std::string &runtime_array_name, size_t size)
@@ -257,13 +399,54 @@ void ShaderVariant::set_runtime_array_sizes(const std::unordered_map<std::string
 	this->runtime_array_sizes = sizes;
 }
 
-const std::string &ShaderVariant::get_preamble() const
+std::string ShaderVariant::get_preamble() const
 {
+	std::string preamble;
+
+	for (auto &process : get_processes())
+	{
+		if (process[0] == 'D')
+		{
+			std::string def = process.substr(1);
+
+			// The "=" needs to turn into a space
+			size_t pos_equal = def.find_first_of("=");
+			if (pos_equal != std::string::npos)
+			{
+				def[pos_equal] = ' ';
+			}
+
+			preamble.append("#define " + def + "\n");
+		}
+		else
+		{
+			preamble.append("#undef " + process.substr(1) + "\n");
+		}
+	}
+
 	return preamble;
 }
 
-const std::vector<std::string> &ShaderVariant::get_processes() const
+std::vector<std::string> ShaderVariant::get_processes() const
 {
+	std::vector<std::string> processes;
+
+	if (flags.none())
+	{
+		return processes;
+	}
+
+	auto &registry = get_flag_registry();
+
+	std::lock_guard<std::mutex> guard{registry.mutex};
+
+	processes.reserve(ordered_flags.size());
+
+	for (auto flag : ordered_flags)
+	{
+		processes.push_back(registry.processes[flag]);
+	}
+
 	return processes;
 }
 
@@ -274,16 +457,19 @@ const std::unordered_map<std::string, size_t> &ShaderVariant::get_runtime_array_
 
 void ShaderVariant::clear()
 {
-	preamble.clear();
-	processes.clear();
+	flags.reset();
+	ordered_flags.clear();
 	runtime_array_sizes.clear();
-	update_id();
 }
 
-void ShaderVariant::update_id()
+bool ShaderVariant::operator==(const ShaderVariant &other) const
 {
-	std::hash<std::string> hasher{};
-	id = hasher(preamble);
+	return flags == other.flags && runtime_array_sizes == other.runtime_array_sizes;
+}
+
+bool ShaderVariant::operator!=(const ShaderVariant &other) const
+{
+	return !(*this == other);
 }
 
 ShaderSource::ShaderSource(const std::string &filename) :
@@ -292,6 +478,99 @@ ShaderSource::ShaderSource(const std::string &filename) :
 {
 	std::hash<std::string> hasher{};
 	id = hasher(std::string{this->source.cbegin(), this->source.cend()});
+
+	track();
+}
+
+ShaderSource::ShaderSource(const ShaderSource &other) :
+    id{other.id},
+    filename{other.filename},
+    source{other.source}
+{
+	track();
+}
+
+ShaderSource::ShaderSource(ShaderSource &&other) :
+    id{other.id},
+    filename{std::move(other.filename)},
+    source{std::move(other.source)}
+{
+	track();
+}
+
+ShaderSource::~ShaderSource()
+{
+	untrack();
+}
+
+ShaderSource &ShaderSource::operator=(const ShaderSource &other)
+{
+	if (this != &other)
+	{
+		untrack();
+
+		id       = other.id;
+		filename = other.filename;
+		source   = other.source;
+
+		track();
+	}
+
+	return *this;
+}
+
+ShaderSource &ShaderSource::operator=(ShaderSource &&other)
+{
+	if (this != &other)
+	{
+		untrack();
+
+		id       = other.id;
+		filename = std::move(other.filename);
+		source   = std::move(other.source);
+
+		track();
+	}
+
+	return *this;
+}
+
+void ShaderSource::track()
+{
+	if (!filename.empty())
+	{
+		std::lock_guard<std::mutex> guard{tracked_sources_mutex};
+		tracked_sources.insert(this);
+	}
+}
+
+void ShaderSource::untrack()
+{
+	std::lock_guard<std::mutex> guard{tracked_sources_mutex};
+	tracked_sources.erase(this);
+}
+
+size_t ShaderSource::reload(const std::string &filename, const std::string &source)
+{
+	std::hash<std::string> hasher{};
+	size_t                 id = hasher(source);
+
+	size_t count = 0;
+
+	std::lock_guard<std::mutex> guard{tracked_sources_mutex};
+
+	for (auto tracked_source : tracked_sources)
+	{
+		// Sources already up to date are left untouched, they may be used by another thread
+		if (tracked_source->filename == filename && tracked_source->id != id)
+		{
+			tracked_source->source = source;
+			tracked_source->id     = id;
+			++count;
+		}
+	}
+
+	return count;
 }
 
 size_t ShaderSource::get_id() const
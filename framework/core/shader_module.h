@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <bitset>
+
 #include "common/helpers.h"
 #include "common/vk_common.h"
 
@@ -50,7 +52,9 @@ enum class ShaderResourceMode
 {
 	Static,
 	Dynamic,
-	UpdateAfterBind
+	UpdateAfterBind,
+	// The whole set of the resource is pushed into the command buffer with VK_KHR_push_descriptor, without allocating a descriptor set
+	PushDescriptor
 };
 
 /// A bitmask of qualifiers applied to a resource
@@ -102,13 +106,43 @@ struct ShaderResource
 /**
  * @brief Adds support for C style preprocessor macros to glsl shaders
  *        enabling you to define or undefine certain symbols
+ *
+ * Every distinct definition is registered once as a flag shared by all the variants,
+ * so a variant is stored as a bitset of flags: identifying, hashing and comparing variants
+ * are integer operations, and the preamble is only generated when compiling a shader.
+ * The directives are generated in the order in which their flags were first registered.
  */
 class ShaderVariant
 {
   public:
+	/// Maximum number of distinct definitions in the application
+	static constexpr size_t MAX_FLAG_COUNT = 256;
+
+	using Flags = std::bitset<MAX_FLAG_COUNT>;
+
 	ShaderVariant() = default;
 
-	ShaderVariant(std::string &&preamble, std::vector<std::string> &&processes);
+	/**
+	 * @brief Creates a variant from glslang processes, as returned by get_processes
+	 * @param processes "D" followed by a definition, or "U" followed by an undefined symbol
+	 */
+	ShaderVariant(const std::vector<std::string> &processes);
+
+	/**
+	 * @brief Registers the flag of a define macro, or finds it if it is already registered
+	 * @param def String which should go to the right of a define directive
+	 * @return The index of the flag
+	 * @throws std::runtime_error if more than MAX_FLAG_COUNT definitions are registered
+	 */
+	static uint32_t register_define(const std::string &def);
+
+	/**
+	 * @brief Registers the flag of an undef macro, or finds it if it is already registered
+	 * @param undef String which should go to the right of an undef directive
+	 * @return The index of the flag
+	 * @throws std::runtime_error if more than MAX_FLAG_COUNT definitions are registered
+	 */
+	static uint32_t register_undefine(const std::string &undef);
 
 	size_t get_id() const;
 
@@ -130,6 +164,16 @@ class ShaderVariant
 	 */
 	void add_undefine(const std::string &undef);
 
+	/**
+	 * @brief Adds a registered flag to the shader, without any string lookup
+	 * @param flag Index returned by register_define or register_undefine
+	 */
+	void add_flag(uint32_t flag);
+
+	bool has_flag(uint32_t flag) const;
+
+	const Flags &get_flags() const;
+
 	/**
 	 * @brief Specifies the size of a named runtime array for automatic reflection. If already specified, overrides the size.
 	 * @param runtime_array_name String under which the runtime array is named in the shader
@@ -140,26 +184,46 @@ class ShaderVariant
 
 	void set_runtime_array_sizes(const std::unordered_map<std::string, size_t> &sizes);
 
-	const std::string &get_preamble() const;
+	/**
+	 * @return The define and undef directives of the variant, in the order they were added
+	 */
+	std::string get_preamble() const;
 
-	const std::vector<std::string> &get_processes() const;
+	/**
+	 * @return The glslang processes of the variant, in the order they were added
+	 */
+	std::vector<std::string> get_processes() const;
 
 	const std::unordered_map<std::string, size_t> &get_runtime_array_sizes() const;
 
 	void clear();
 
-  private:
-	size_t id;
+	bool operator==(const ShaderVariant &other) const;
+
+	bool operator!=(const ShaderVariant &other) const;
 
-	std::string preamble;
+  private:
+	Flags flags;
 
-	std::vector<std::string> processes;
+	/// Flags in the order they were added, which is the order of the directives
+	std::vector<uint32_t> ordered_flags;
 
 	std::unordered_map<std::string, size_t> runtime_array_sizes;
-
-	void update_id();
 };
 
+/**
+ * @brief Expands the #include lines of GLSL source recursively, as done before compiling it
+ * @param source The GLSL source, include paths are relative to the shader directory
+ * @param includes If not null, filled with the paths of all the files included directly or indirectly
+ * @return The source passed to the GLSLCompiler
+ */
+std::vector<uint8_t> expand_shader_includes(const std::string &source, std::set<std::string> *includes = nullptr);
+
+/**
+ * @brief GLSL source of a shader.
+ * The sources loaded from a file are tracked while alive, so that they can be
+ * reloaded when the file is edited, see ShaderSource::reload.
+ */
 class ShaderSource
 {
   public:
@@ -167,6 +231,16 @@ class ShaderSource
 
 	ShaderSource(const std::string &filename);
 
+	ShaderSource(const ShaderSource &other);
+
+	ShaderSource(ShaderSource &&other);
+
+	~ShaderSource();
+
+	ShaderSource &operator=(const ShaderSource &other);
+
+	ShaderSource &operator=(ShaderSource &&other);
+
 	size_t get_id() const;
 
 	const std::string &get_filename() const;
@@ -175,7 +249,20 @@ class ShaderSource
 
 	const std::string &get_source() const;
 
+	/**
+	 * @brief Replaces the source of all the live objects loaded from a file.
+	 *        Must not be called while the sources are in use by other threads, e.g. between frames.
+	 * @param filename The shader file, relative to the shader directory
+	 * @param source The new source of the file
+	 * @return The number of objects updated
+	 */
+	static size_t reload(const std::string &filename, const std::string &source);
+
   private:
+	void track();
+
+	void untrack();
+
 	size_t id;
 
 	std::string filename;
@@ -201,6 +288,20 @@ class ShaderModule
 	             const std::string &   entry_point,
 	             const ShaderVariant & shader_variant);
 
+	/**
+	 * @brief Creates a shader module from precompiled SPIR-V, e.g. loaded with fs::read_shader_binary
+	 * @param device The device
+	 * @param stage The shader stage
+	 * @param spirv The SPIR-V code
+	 * @param entry_point The entry point of the shader stage
+	 * @param shader_variant The variant the code was compiled with, used for reflection
+	 */
+	ShaderModule(Device &                     device,
+	             VkShaderStageFlagBits        stage,
+	             const std::vector<uint32_t> &spirv,
+	             const std::string &          entry_point,
+	             const ShaderVariant &        shader_variant = {});
+
 	ShaderModule(const ShaderModule &) = delete;
 
 	ShaderModule(ShaderModule &&other);
@@ -221,6 +322,23 @@ class ShaderModule
 
 	const std::vector<uint32_t> &get_binary() const;
 
+	/**
+	 * @return The file the module was compiled from, empty if created from SPIR-V or from a source without file
+	 */
+	const std::string &get_source_filename() const;
+
+	/**
+	 * @return The files included by the source, directly or indirectly
+	 */
+	const std::set<std::string> &get_source_includes() const;
+
+	const ShaderVariant &get_shader_variant() const;
+
+	/**
+	 * @return Time in milliseconds spent reflecting the shader resources, or loading them from the SPIRVCache
+	 */
+	double get_reflection_time() const;
+
 	/**
 	 * @brief Flags a resource to use a different method of being bound to the shader
 	 * @param resource_name The name of the shader resource
@@ -229,6 +347,11 @@ class ShaderModule
 	void set_resource_mode(const std::string &resource_name, const ShaderResourceMode &resource_mode);
 
   private:
+	/**
+	 * @brief Reflects the resources of the SPIR-V code and generates the id of the module
+	 */
+	void reflect(const std::string &name, const ShaderVariant &shader_variant);
+
 	Device &device;
 
 	/// Shader unique id
@@ -246,5 +369,13 @@ class ShaderModule
 	std::vector<ShaderResource> resources;
 
 	std::string info_log;
+
+	double reflection_time{0.0};
+
+	std::string source_filename;
+
+	std::set<std::string> source_includes;
+
+	ShaderVariant shader_variant;
 };
 }        // namespace vkb
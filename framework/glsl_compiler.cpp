@@ -17,14 +17,26 @@
 
 #include "glsl_compiler.h"
 
+#include <mutex>
+
+#include <ctpl_stl.h>
+
 VKBP_DISABLE_WARNINGS()
 #include <SPIRV/GLSL.std.450.h>
 #include <SPIRV/GlslangToSpv.h>
 #include <StandAlone/ResourceLimits.h>
 #include <glslang/Include/ShHandle.h>
 #include <glslang/OSDependent/osinclude.h>
+#if defined(VKB_SPIRV_OPTIMIZER)
+#	include <spirv-tools/optimizer.hpp>
+#endif
 VKBP_ENABLE_WARNINGS()
 
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "common/strings.h"
+#include "spirv_cache.h"
+
 namespace vkb
 {
 namespace
@@ -73,11 +85,146 @@ inline EShLanguage FindShaderLanguage(VkShaderStageFlagBits stage)
 			return EShLangVertex;
 	}
 }
+
+/**
+ * @brief Builds the SPIR-V cache key of a compilation, covering every input which can change its output
+ */
+std::string get_spirv_cache_key(VkShaderStageFlagBits             stage,
+                                const std::vector<uint8_t>       &glsl_source,
+                                const std::string                &entry_point,
+                                const ShaderVariant              &shader_variant,
+                                glslang::EShTargetLanguage        target_language,
+                                glslang::EShTargetLanguageVersion target_language_version,
+                                SPIRVOptimization                 optimization)
+{
+	std::ostringstream key;
+
+	write(key,
+	      std::string{glslang::GetGlslVersionString()},
+	      std::string{glslang::GetEsslVersionString()},
+	      glslang::GetKhronosToolId(),
+	      target_language,
+	      target_language_version,
+	      optimization,
+	      stage,
+	      entry_point,
+	      shader_variant.get_preamble(),
+	      shader_variant.get_processes().size());
+
+	for (auto &process : shader_variant.get_processes())
+	{
+		write(key, process);
+	}
+
+	write(key, std::string{glsl_source.begin(), glsl_source.end()});
+
+	return key.str();
+}
+
+/// Size reduction of all the optimized shaders, guarded by optimization_stats_mutex
+SPIRVOptimizationStats optimization_stats;
+
+std::mutex optimization_stats_mutex;
+
+#if defined(VKB_SPIRV_OPTIMIZER)
+/**
+ * @brief Counts the instructions of SPIR-V code
+ */
+uint32_t count_spirv_instructions(const std::vector<uint32_t> &spirv)
+{
+	uint32_t count = 0;
+
+	// The header takes 5 words, then the high 16 bits of the first word of each instruction are its word count
+	for (size_t offset = 5; offset < spirv.size(); ++count)
+	{
+		uint32_t word_count = spirv[offset] >> 16;
+
+		if (word_count == 0)
+		{
+			break;
+		}
+
+		offset += word_count;
+	}
+
+	return count;
+}
+
+spv_target_env get_spirv_target_env(glslang::EShTargetLanguageVersion target_language_version)
+{
+	switch (target_language_version)
+	{
+		case glslang::EShTargetSpv_1_3:
+			return SPV_ENV_VULKAN_1_1;
+		case glslang::EShTargetSpv_1_4:
+			return SPV_ENV_VULKAN_1_1_SPIRV_1_4;
+		case glslang::EShTargetSpv_1_5:
+			return SPV_ENV_VULKAN_1_2;
+		default:
+			return SPV_ENV_VULKAN_1_0;
+	}
+}
+
+/**
+ * @brief Optimizes SPIR-V code with SPIRV-Tools
+ * @param spirv The code to optimize, replaced by the optimized code on success
+ * @return False if the code could not be optimized, in which case it is left untouched
+ */
+bool optimize_spirv(std::vector<uint32_t> &spirv, SPIRVOptimization optimization, glslang::EShTargetLanguageVersion target_language_version, std::string &info_log)
+{
+	spvtools::Optimizer optimizer{get_spirv_target_env(target_language_version)};
+
+	optimizer.SetMessageConsumer([&info_log](spv_message_level_t, const char *, const spv_position_t &, const char *message) {
+		info_log += std::string{message} + "\n";
+	});
+
+	if (optimization == SPIRVOptimization::Size)
+	{
+		optimizer.RegisterSizePasses();
+	}
+	else
+	{
+		optimizer.RegisterPerformancePasses();
+	}
+
+	// The resources reflected from the optimized code must still match what the framework binds
+	spvtools::OptimizerOptions options;
+	options.set_preserve_bindings(true);
+	options.set_preserve_spec_constants(true);
+
+	std::vector<uint32_t> optimized_spirv;
+
+	if (!optimizer.Run(spirv.data(), spirv.size(), &optimized_spirv, options))
+	{
+		return false;
+	}
+
+	spirv = std::move(optimized_spirv);
+
+	return true;
+}
+#endif
 }        // namespace
 
 glslang::EShTargetLanguage        GLSLCompiler::env_target_language         = glslang::EShTargetLanguage::EShTargetNone;
 glslang::EShTargetLanguageVersion GLSLCompiler::env_target_language_version = (glslang::EShTargetLanguageVersion) 0;
 
+#if defined(VKB_SPIRV_OPTIMIZER)
+SPIRVOptimization GLSLCompiler::optimization = SPIRVOptimization::Performance;
+#else
+SPIRVOptimization GLSLCompiler::optimization = SPIRVOptimization::None;
+#endif
+
+GLSLCompiler::ProcessScope::ProcessScope()
+{
+	glslang::InitializeProcess();
+}
+
+GLSLCompiler::ProcessScope::~ProcessScope()
+{
+	glslang::FinalizeProcess();
+}
+
 void GLSLCompiler::set_target_environment(glslang::EShTargetLanguage target_language, glslang::EShTargetLanguageVersion target_language_version)
 {
 	GLSLCompiler::env_target_language         = target_language;
@@ -90,6 +237,29 @@ void GLSLCompiler::reset_target_environment()
 	GLSLCompiler::env_target_language_version = (glslang::EShTargetLanguageVersion) 0;
 }
 
+void GLSLCompiler::set_optimization(SPIRVOptimization new_optimization)
+{
+#if defined(VKB_SPIRV_OPTIMIZER)
+	GLSLCompiler::optimization = new_optimization;
+#else
+	if (new_optimization != SPIRVOptimization::None)
+	{
+		LOGW("SPIR-V optimization is not available, build with VKB_SPIRV_OPTIMIZER to enable it");
+	}
+#endif
+}
+
+SPIRVOptimization GLSLCompiler::get_optimization()
+{
+	return GLSLCompiler::optimization;
+}
+
+SPIRVOptimizationStats GLSLCompiler::get_optimization_stats()
+{
+	std::lock_guard<std::mutex> guard{optimization_stats_mutex};
+	return optimization_stats;
+}
+
 bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     const std::vector<uint8_t> &glsl_source,
                                     const std::string &         entry_point,
@@ -97,8 +267,16 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
                                     std::vector<std::uint32_t> &spirv,
                                     std::string &               info_log)
 {
-	// Initialize glslang library.
-	glslang::InitializeProcess();
+	// The source is already include-expanded, so the key changes with any of the included files
+	auto cache_key = get_spirv_cache_key(stage, glsl_source, entry_point, shader_variant, GLSLCompiler::env_target_language, GLSLCompiler::env_target_language_version, GLSLCompiler::optimization);
+
+	if (SPIRVCache::load(cache_key, spirv))
+	{
+		return true;
+	}
+
+	// Initialize glslang library, it is shut down when leaving the scope
+	ProcessScope glslang_scope;
 
 	EShMessages messages = static_cast<EShMessages>(EShMsgDefault | EShMsgVulkanRules | EShMsgSpvRules);
 
@@ -108,11 +286,14 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 	const char *file_name_list[1] = {""};
 	const char *shader_source     = reinterpret_cast<const char *>(source.data());
 
+	// The shader keeps a pointer to the preamble until it is parsed
+	std::string preamble = shader_variant.get_preamble();
+
 	glslang::TShader shader(language);
 	shader.setStringsWithLengthsAndNames(&shader_source, nullptr, file_name_list, 1);
 	shader.setEntryPoint(entry_point.c_str());
 	shader.setSourceEntryPoint(entry_point.c_str());
-	shader.setPreamble(shader_variant.get_preamble().c_str());
+	shader.setPreamble(preamble.c_str());
 	shader.addProcesses(shader_variant.get_processes());
 	if (GLSLCompiler::env_target_language != glslang::EShTargetLanguage::EShTargetNone)
 	{
@@ -162,9 +343,72 @@ bool GLSLCompiler::compile_to_spirv(VkShaderStageFlagBits       stage,
 
 	info_log += logger.getAllMessages() + "\n";
 
-	// Shutdown glslang library.
-	glslang::FinalizeProcess();
+#if defined(VKB_SPIRV_OPTIMIZER)
+	if (GLSLCompiler::optimization != SPIRVOptimization::None)
+	{
+		auto instruction_count_before = count_spirv_instructions(spirv);
+		auto size_before              = spirv.size() * sizeof(uint32_t);
+
+		if (optimize_spirv(spirv, GLSLCompiler::optimization, GLSLCompiler::env_target_language_version, info_log))
+		{
+			auto instruction_count_after = count_spirv_instructions(spirv);
+			auto size_after              = spirv.size() * sizeof(uint32_t);
+
+			LOGI("Optimized {} shader SPIR-V: {} -> {} instructions, {} -> {} bytes",
+			     shader_stage_to_string(stage), instruction_count_before, instruction_count_after, size_before, size_after);
+
+			std::lock_guard<std::mutex> guard{optimization_stats_mutex};
+
+			optimization_stats.module_count++;
+			optimization_stats.instruction_count_before += instruction_count_before;
+			optimization_stats.instruction_count_after += instruction_count_after;
+			optimization_stats.size_before += size_before;
+			optimization_stats.size_after += size_after;
+		}
+		else
+		{
+			LOGW("Failed to optimize {} shader SPIR-V, keeping the unoptimized code", shader_stage_to_string(stage));
+		}
+	}
+#endif
+
+	SPIRVCache::store(cache_key, spirv);
 
 	return true;
 }
+
+bool GLSLCompiler::compile_to_spirv(std::vector<GLSLCompileJob> &jobs, uint32_t thread_count)
+{
+	if (thread_count == 0)
+	{
+		thread_count = std::thread::hardware_concurrency();
+		thread_count = thread_count == 0 ? 1 : thread_count;
+	}
+
+	// Keep glslang initialized until all the jobs are done
+	ProcessScope glslang_scope;
+
+	ctpl::thread_pool thread_pool(thread_count);
+
+	std::vector<std::future<void>> futures;
+	futures.reserve(jobs.size());
+
+	for (auto &job : jobs)
+	{
+		futures.push_back(thread_pool.push([this, &job](size_t) {
+			job.compiled = compile_to_spirv(job.stage, job.glsl_source, job.entry_point, job.shader_variant, job.spirv, job.info_log);
+		}));
+	}
+
+	bool compiled = true;
+
+	for (size_t i = 0; i < futures.size(); ++i)
+	{
+		futures[i].get();
+
+		compiled = compiled && jobs[i].compiled;
+	}
+
+	return compiled;
+}
 }        // namespace vkb
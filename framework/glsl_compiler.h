@@ -31,6 +31,53 @@ VKBP_ENABLE_WARNINGS()
 
 namespace vkb
 {
+/// Optimization recipe applied by SPIRV-Tools to the SPIR-V generated from GLSL
+enum class SPIRVOptimization
+{
+	None,
+	/// Same passes as spirv-opt -O
+	Performance,
+	/// Same passes as spirv-opt -Os
+	Size
+};
+
+/// Size of the SPIR-V code before and after optimization, summed over the optimized shaders
+struct SPIRVOptimizationStats
+{
+	uint32_t module_count{0};
+
+	uint64_t instruction_count_before{0};
+
+	uint64_t instruction_count_after{0};
+
+	uint64_t size_before{0};
+
+	uint64_t size_after{0};
+};
+
+/**
+ * @brief A shader compiled by a batch of GLSLCompiler::compile_to_spirv
+ */
+struct GLSLCompileJob
+{
+	VkShaderStageFlagBits stage{VK_SHADER_STAGE_VERTEX_BIT};
+
+	std::vector<uint8_t> glsl_source;
+
+	std::string entry_point{"main"};
+
+	ShaderVariant shader_variant;
+
+	/// Generated SPIRV code
+	std::vector<uint32_t> spirv;
+
+	/// Log messages of the compilation
+	std::string info_log;
+
+	/// Whether the compilation succeeded
+	bool compiled{false};
+};
+
 /// Helper class to generate SPIRV code from GLSL source
 /// A very simple version of the glslValidator application
 class GLSLCompiler
@@ -39,7 +86,25 @@ class GLSLCompiler
 	static glslang::EShTargetLanguage        env_target_language;
 	static glslang::EShTargetLanguageVersion env_target_language_version;
 
+	static SPIRVOptimization optimization;
+
   public:
+	/**
+	 * @brief Keeps the glslang library initialized while alive, so that consecutive
+	 *        compilations do not tear down and rebuild its shared symbol tables
+	 */
+	class ProcessScope
+	{
+	  public:
+		ProcessScope();
+
+		~ProcessScope();
+
+		ProcessScope(const ProcessScope &) = delete;
+
+		ProcessScope &operator=(const ProcessScope &) = delete;
+	};
+
 	/**
 	 * @brief Set the glslang target environment to translate to when generating code
 	 * @param target_language The language to translate to
@@ -54,7 +119,21 @@ class GLSLCompiler
 	static void reset_target_environment();
 
 	/**
-	 * @brief Compiles GLSL to SPIRV code
+	 * @brief Sets the optimization applied to the generated SPIR-V, before it is stored in the SPIRVCache
+	 *        Only available when built with VKB_SPIRV_OPTIMIZER, in which case it defaults to Performance
+	 * @param optimization The optimization recipe
+	 */
+	static void set_optimization(SPIRVOptimization optimization);
+
+	static SPIRVOptimization get_optimization();
+
+	/**
+	 * @return The size reduction of all the shaders optimized since the start of the application
+	 */
+	static SPIRVOptimizationStats get_optimization_stats();
+
+	/**
+	 * @brief Compiles GLSL to SPIRV code, or loads it from the SPIRVCache if it was compiled before
 	 * @param stage The Vulkan shader stage flag
 	 * @param glsl_source The GLSL source code to be compiled
 	 * @param entry_point The entrypoint function name of the shader stage
@@ -68,5 +147,14 @@ class GLSLCompiler
 	                      const ShaderVariant &       shader_variant,
 	                      std::vector<std::uint32_t> &spirv,
 	                      std::string &               info_log);
+
+	/**
+	 * @brief Compiles a batch of shaders across a pool of threads
+	 *        glslang is initialized once for the batch, and each thread compiles with its own glslang objects
+	 * @param jobs The shaders to compile, their outputs are filled in place
+	 * @param thread_count Number of threads to use, the hardware concurrency if 0
+	 * @return True if every shader compiled successfully
+	 */
+	bool compile_to_spirv(std::vector<GLSLCompileJob> &jobs, uint32_t thread_count = 0);
 };
 }        // namespace vkb
@@ -37,7 +37,8 @@ const std::unordered_map<Type, std::string> relative_paths = {{Type::Assets, "as
                                                               {Type::Storage, "output/"},
                                                               {Type::Screenshots, "output/images/"},
                                                               {Type::Logs, "output/logs/"},
-                                                              {Type::Graphs, "output/graphs/"}};
+                                                              {Type::Graphs, "output/graphs/"},
+                                                              {Type::ShaderCache, "output/shader_cache/"}};
 
 const std::string get(const Type type, const std::string &file)
 {
@@ -203,6 +204,16 @@ void write_temp(const std::vector<uint8_t> &data, const std::string &filename, c
 	write_binary_file(data, path::get(path::Type::Temp) + filename, count);
 }
 
+std::vector<uint8_t> read_storage(const std::string &filename, const uint32_t count)
+{
+	return read_binary_file(path::get(path::Type::Storage) + filename, count);
+}
+
+void write_storage(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count)
+{
+	write_binary_file(data, path::get(path::Type::Storage) + filename, count);
+}
+
 void write_image(const uint8_t *data, const std::string &filename, const uint32_t width, const uint32_t height, const uint32_t components, const uint32_t row_stride)
 {
 	stbi_write_png((path::get(path::Type::Screenshots) + filename + ".png").c_str(), width, height, components, data, row_stride);
@@ -42,6 +42,7 @@ enum Type
 	Screenshots,
 	Logs,
 	Graphs,
+	ShaderCache,
 	/* NewFolder */
 	TotalRelativePathTypes,
 
@@ -136,6 +137,26 @@ std::vector<uint8_t> read_temp(const std::string &filename, const uint32_t count
  */
 void write_temp(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count = 0);
 
+/**
+ * @brief Helper to read a file from permanent storage into a byte-array
+ *
+ * @param filename The path to the file (relative to the storage directory)
+ * @param count (optional) How many bytes to read. If 0 or not specified, the size
+ * of the file will be used.
+ * @return A vector filled with data read from the file
+ */
+std::vector<uint8_t> read_storage(const std::string &filename, const uint32_t count = 0);
+
+/**
+ * @brief Helper to write to a file in permanent storage
+ *
+ * @param data A vector filled with data to write
+ * @param filename The path to the file (relative to the storage directory)
+ * @param count (optional) How many bytes to write. If 0 or not specified, the size
+ * of data will be used.
+ */
+void write_storage(const std::vector<uint8_t> &data, const std::string &filename, const uint32_t count = 0);
+
 /**
  * @brief Helper to write to a png image in permanent storage
  *
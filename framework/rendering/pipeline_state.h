@@ -170,9 +170,16 @@ inline void SpecializationConstantState::set_constant<bool>(std::uint32_t consta
 	set_constant(constant_id, to_bytes(static_cast<std::uint32_t>(data)));
 }
 
+/**
+ * @brief The state of a graphics or compute pipeline.
+ *        Every part of the state keeps its own hash, updated by the setter which changes it,
+ *        so that the hash of the whole state used to look up pipelines is computed in constant time.
+ */
 class PipelineState
 {
   public:
+	PipelineState();
+
 	void reset();
 
 	void set_pipeline_layout(PipelineLayout &pipeline_layout);
@@ -223,7 +230,18 @@ class PipelineState
 
 	void clear_dirty();
 
+	/// @brief Flags the state as changed, so that a pipeline is bound for it again
+	void set_dirty();
+
+	/**
+	 * @return A hash of the whole state, combined from the hashes of its parts
+	 */
+	size_t get_hash() const;
+
   private:
+	/// @brief Computes the hashes of all the parts of the state
+	void update_hashes();
+
 	bool dirty{false};
 
 	PipelineLayout *pipeline_layout{nullptr};
@@ -247,5 +265,25 @@ class PipelineState
 	ColorBlendState color_blend_state{};
 
 	uint32_t subpass_index{0U};
+
+	size_t pipeline_layout_hash{0U};
+
+	size_t render_pass_hash{0U};
+
+	size_t specialization_constant_hash{0U};
+
+	size_t vertex_input_hash{0U};
+
+	size_t input_assembly_hash{0U};
+
+	size_t rasterization_hash{0U};
+
+	size_t viewport_hash{0U};
+
+	size_t multisample_hash{0U};
+
+	size_t depth_stencil_hash{0U};
+
+	size_t color_blend_hash{0U};
 };
 }        // namespace vkb
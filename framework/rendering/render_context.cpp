@@ -85,6 +85,8 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 			    swapchain->get_usage()};
 			auto render_target = create_render_target_func(std::move(swapchain_image));
 			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			frames.back()->share_buffer_rings(*frames.front());
+			frames.back()->set_descriptor_set_limits(descriptor_set_limits);
 		}
 	}
 	else
@@ -100,6 +102,7 @@ void RenderContext::prepare(size_t thread_count, RenderTarget::CreateFunc create
 
 		auto render_target = create_render_target_func(std::move(color_image));
 		frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+		frames.back()->set_descriptor_set_limits(descriptor_set_limits);
 	}
 
 	this->create_render_target_func = create_render_target_func;
@@ -113,6 +116,16 @@ void RenderContext::set_present_mode_priority(const std::vector<VkPresentModeKHR
 	present_mode_priority_list = new_present_mode_priority_list;
 }
 
+void RenderContext::set_descriptor_set_limits(const ResourceCacheLimits &limits)
+{
+	descriptor_set_limits = limits;
+
+	for (auto &frame : frames)
+	{
+		frame->set_descriptor_set_limits(limits);
+	}
+}
+
 void RenderContext::set_surface_format_priority(const std::vector<VkSurfaceFormatKHR> &new_surface_format_priority_list)
 {
 	assert(!new_surface_format_priority_list.empty() && "Priority list must not be empty");
@@ -230,6 +243,8 @@ void RenderContext::recreate()
 		{
 			// Create a new frame if the new swapchain has more images than current frames
 			frames.emplace_back(std::make_unique<RenderFrame>(device, std::move(render_target), thread_count));
+			frames.back()->share_buffer_rings(*frames.front());
+			frames.back()->set_descriptor_set_limits(descriptor_set_limits);
 		}
 
 		++frame_it;
@@ -352,6 +367,9 @@ void RenderContext::begin_frame()
 
 	// Wait on all resource to be freed from the previous render to this frame
 	wait_frame();
+
+	// Cached objects last used by this frame are no longer in use by the GPU
+	device.get_resource_cache().begin_frame(to_u32(frames.size()));
 }
 
 VkSemaphore RenderContext::submit(const Queue &queue, const std::vector<CommandBuffer *> &command_buffers, VkSemaphore wait_semaphore, VkPipelineStageFlags wait_pipeline_stage)
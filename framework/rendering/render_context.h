@@ -97,6 +97,11 @@ class RenderContext
 	 */
 	void set_surface_format_priority(const std::vector<VkSurfaceFormatKHR> &surface_format_priority_list);
 
+	/**
+	 * @brief Sets the limits of the descriptor sets cached by each RenderFrame, including the frames created later
+	 */
+	void set_descriptor_set_limits(const ResourceCacheLimits &limits);
+
 	/**
 	 * @brief Prepares the RenderFrames for rendering
 	 * @param thread_count The number of threads in the application, necessary to allocate this many resource pools for each RenderFrame
@@ -276,6 +281,8 @@ class RenderContext
 	VkSurfaceTransformFlagBitsKHR pre_transform{VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR};
 
 	size_t thread_count{1};
+
+	ResourceCacheLimits descriptor_set_limits;
 };
 
 }        // namespace vkb
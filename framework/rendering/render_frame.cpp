@@ -32,11 +32,15 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
 	for (auto &usage_it : supported_usage_map)
 	{
 		std::vector<std::pair<BufferPool, BufferBlock *>> usage_buffer_pools;
+		std::vector<std::shared_ptr<BufferRing>>           usage_buffer_rings;
 		for (size_t i = 0; i < thread_count; ++i)
 		{
 			usage_buffer_pools.push_back(std::make_pair(BufferPool{device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first}, nullptr));
+			usage_buffer_rings.push_back(std::make_shared<BufferRing>(device, BUFFER_POOL_BLOCK_SIZE * 1024 * usage_it.second, usage_it.first));
 		}
 
+		buffer_rings.emplace(usage_it.first, std::move(usage_buffer_rings));
+
 		auto res_ins_it = buffer_pools.emplace(usage_it.first, std::move(usage_buffer_pools));
 
 		if (!res_ins_it.second)
@@ -50,6 +54,9 @@ RenderFrame::RenderFrame(Device &device, std::unique_ptr<RenderTarget> &&render_
 		descriptor_pools.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorPool>>());
 		descriptor_sets.push_back(std::make_unique<std::unordered_map<std::size_t, DescriptorSet>>());
 	}
+
+	descriptor_set_lrus.resize(thread_count);
+	image_view_indices.resize(thread_count);
 }
 
 Device &RenderFrame::get_device()
@@ -59,6 +66,12 @@ Device &RenderFrame::get_device()
 
 void RenderFrame::update_render_target(std::unique_ptr<RenderTarget> &&render_target)
 {
+	// The views of the previous render target are destroyed with it
+	if (swapchain_render_target)
+	{
+		release_descriptor_sets(swapchain_render_target->get_views());
+	}
+
 	swapchain_render_target = std::move(render_target);
 }
 
@@ -68,6 +81,26 @@ void RenderFrame::reset()
 
 	fence_pool.reset();
 
+	++frame_index;
+
+	// The fence covers every use of the descriptor sets of this frame, so any of them can be evicted
+	uint32_t evicted_count{0};
+
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		evicted_count += descriptor_set_lrus[i].evict(*descriptor_sets[i], descriptor_set_limits, frame_index, 1,
+		                                              [this, i](std::size_t key, DescriptorSet &descriptor_set) {
+			                                              image_view_indices[i].remove(key, descriptor_set);
+			                                              descriptor_set.get_descriptor_pool().free(descriptor_set.get_handle());
+		                                              });
+	}
+
+	// Reported with the evictions of the resource cache
+	if (evicted_count > 0)
+	{
+		device.get_resource_cache().add_evicted_count(evicted_count);
+	}
+
 	for (auto &command_pools_per_queue : command_pools)
 	{
 		for (auto &command_pool : command_pools_per_queue.second)
@@ -85,6 +118,15 @@ void RenderFrame::reset()
 		}
 	}
 
+	// The allocations this frame made from the rings before the fence are no longer in use
+	for (auto &buffer_rings_per_usage : buffer_rings)
+	{
+		for (auto &buffer_ring : buffer_rings_per_usage.second)
+		{
+			buffer_ring->begin_frame(*this);
+		}
+	}
+
 	semaphore_pool.reset();
 }
 
@@ -181,7 +223,96 @@ DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descript
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
 	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
-	return request_resource(device, nullptr, *descriptor_sets.at(thread_index), descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	std::size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	return request_hashed_descriptor_set(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos, thread_index);
+}
+
+DescriptorSet &RenderFrame::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, size_t bindings_hash, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
+
+	std::size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, descriptor_pool);
+	hash_combine(hash, bindings_hash);
+
+	return request_hashed_descriptor_set(hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos, thread_index);
+}
+
+DescriptorSet *RenderFrame::find_descriptor_set(DescriptorSetLayout &descriptor_set_layout, size_t bindings_hash, size_t thread_index)
+{
+	assert(thread_index < thread_count && "Thread index is out of bounds");
+
+	auto &descriptor_pool = request_resource(device, nullptr, *descriptor_pools.at(thread_index), descriptor_set_layout);
+
+	std::size_t hash{0U};
+	hash_param(hash, descriptor_set_layout, descriptor_pool);
+	hash_combine(hash, bindings_hash);
+
+	auto &thread_descriptor_sets = *descriptor_sets.at(thread_index);
+
+	auto descriptor_set_it = thread_descriptor_sets.find(hash);
+
+	if (descriptor_set_it == thread_descriptor_sets.end())
+	{
+		return nullptr;
+	}
+
+	descriptor_set_lrus[thread_index].touch(hash, frame_index);
+
+	return &descriptor_set_it->second;
+}
+
+DescriptorSet &RenderFrame::request_hashed_descriptor_set(std::size_t hash, DescriptorSetLayout &descriptor_set_layout, DescriptorPool &descriptor_pool, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos, size_t thread_index)
+{
+	auto &thread_descriptor_sets = *descriptor_sets.at(thread_index);
+
+	descriptor_set_lrus[thread_index].touch(hash, frame_index);
+
+	auto descriptor_set_it = thread_descriptor_sets.find(hash);
+
+	if (descriptor_set_it != thread_descriptor_sets.end())
+	{
+		return descriptor_set_it->second;
+	}
+
+	auto &descriptor_set = request_hashed_resource(device, nullptr, thread_descriptor_sets, hash, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+
+	image_view_indices[thread_index].add(hash, descriptor_set);
+
+	return descriptor_set;
+}
+
+void RenderFrame::release_descriptor_sets(const std::vector<core::ImageView> &image_views)
+{
+	for (size_t i = 0; i < thread_count; ++i)
+	{
+		auto &thread_descriptor_sets = *descriptor_sets[i];
+
+		for (auto &image_view : image_views)
+		{
+			// Only visit the descriptor sets referring to the view
+			for (auto key : image_view_indices[i].take(image_view.get_handle()))
+			{
+				auto descriptor_set_it = thread_descriptor_sets.find(key);
+
+				if (descriptor_set_it == thread_descriptor_sets.end())
+				{
+					continue;
+				}
+
+				image_view_indices[i].remove(key, descriptor_set_it->second);
+				descriptor_set_it->second.get_descriptor_pool().free(descriptor_set_it->second.get_handle());
+
+				thread_descriptor_sets.erase(descriptor_set_it);
+				descriptor_set_lrus[i].erase(key);
+			}
+		}
+	}
 }
 
 void RenderFrame::update_descriptor_sets(size_t thread_index)
@@ -200,6 +331,16 @@ void RenderFrame::clear_descriptors()
 		desc_sets_per_thread->clear();
 	}
 
+	for (auto &desc_set_lru : descriptor_set_lrus)
+	{
+		desc_set_lru.clear();
+	}
+
+	for (auto &image_view_index : image_view_indices)
+	{
+		image_view_index.clear();
+	}
+
 	for (auto &desc_pools_per_thread : descriptor_pools)
 	{
 		for (auto &desc_pool : *desc_pools_per_thread)
@@ -209,15 +350,39 @@ void RenderFrame::clear_descriptors()
 	}
 }
 
+void RenderFrame::set_descriptor_set_limits(const ResourceCacheLimits &limits)
+{
+	descriptor_set_limits = limits;
+}
+
 void RenderFrame::set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy)
 {
 	buffer_allocation_strategy = new_strategy;
 }
 
+void RenderFrame::share_buffer_rings(const RenderFrame &other)
+{
+	assert(thread_count == other.thread_count && "Frames sharing buffer rings must have the same number of threads");
+
+	buffer_rings = other.buffer_rings;
+}
+
 BufferAllocation RenderFrame::allocate_buffer(const VkBufferUsageFlags usage, const VkDeviceSize size, size_t thread_index)
 {
 	assert(thread_index < thread_count && "Thread index is out of bounds");
 
+	if (buffer_allocation_strategy == BufferAllocationStrategy::RingBuffer)
+	{
+		auto buffer_ring_it = buffer_rings.find(usage);
+		if (buffer_ring_it == buffer_rings.end())
+		{
+			LOGE("No buffer ring for buffer usage {}", usage);
+			return BufferAllocation{};
+		}
+
+		return buffer_ring_it->second.at(thread_index)->allocate(to_u32(size));
+	}
+
 	uint32_t block_multiplier = supported_usage_map.at(usage);
 
 	if (size > BUFFER_POOL_BLOCK_SIZE * 1024 * block_multiplier)
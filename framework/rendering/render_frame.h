@@ -37,7 +37,10 @@ namespace vkb
 enum BufferAllocationStrategy
 {
 	OneAllocationPerBuffer,
-	MultipleAllocationsPerBuffer
+	MultipleAllocationsPerBuffer,
+	/// Allocations come from a ring buffer per usage shared by the frames of a render context.
+	/// Their offsets change every frame, so it suits dynamic buffers, whose offsets are not part of the descriptor sets
+	RingBuffer
 };
 
 /**
@@ -94,6 +97,7 @@ class RenderFrame
 
 	/**
 	 * @brief Called when the swapchain changes
+	 *        Releases the descriptor sets referring to the views of the previous render target
 	 * @param render_target A new render target with updated images
 	 */
 	void update_render_target(std::unique_ptr<RenderTarget> &&render_target);
@@ -122,14 +126,53 @@ class RenderFrame
 	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
 	                                      size_t                                    thread_index = 0);
 
+	/**
+	 * @brief Requests a descriptor set with a key computed by the caller from the bound resources
+	 * @param descriptor_set_layout The layout of the descriptor set
+	 * @param bindings_hash A hash identifying the buffer infos and image infos
+	 * @param buffer_infos The buffer infos, only used if the descriptor set needs to be created
+	 * @param image_infos The image infos, only used if the descriptor set needs to be created
+	 * @param thread_index Index of the thread recording the command buffer
+	 */
+	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
+	                                      size_t                                    bindings_hash,
+	                                      const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+	                                      const BindingMap<VkDescriptorImageInfo> & image_infos,
+	                                      size_t                                    thread_index = 0);
+
+	/**
+	 * @brief Finds a descriptor set previously requested with the same key, without creating it
+	 * @param descriptor_set_layout The layout of the descriptor set
+	 * @param bindings_hash A hash identifying the buffer infos and image infos
+	 * @param thread_index Index of the thread recording the command buffer
+	 * @return The descriptor set, or nullptr if it was not created yet
+	 */
+	DescriptorSet *find_descriptor_set(DescriptorSetLayout &descriptor_set_layout,
+	                                   size_t               bindings_hash,
+	                                   size_t               thread_index = 0);
+
 	void clear_descriptors();
 
+	/**
+	 * @brief Sets the limits of the descriptor sets cached per thread by the frame, applied when the frame is reset
+	 *        Descriptor sets are stamped when requested, not when a cached secondary command buffer using them is replayed,
+	 *        so limits should not be combined with GeometrySubpass::set_command_caching
+	 */
+	void set_descriptor_set_limits(const ResourceCacheLimits &limits);
+
 	/**
 	 * @brief Sets a new buffer allocation strategy
 	 * @param new_strategy The new buffer allocation strategy
 	 */
 	void set_buffer_allocation_strategy(BufferAllocationStrategy new_strategy);
 
+	/**
+	 * @brief Allocates from the buffer rings of another frame, so that all the frames
+	 *        of a render context share the same rings
+	 * @param other A frame with the same number of threads
+	 */
+	void share_buffer_rings(const RenderFrame &other);
+
 	/**
 	 * @param usage Usage of the buffer
 	 * @param size Amount of memory required
@@ -155,6 +198,21 @@ class RenderFrame
 	 */
 	std::vector<std::unique_ptr<CommandPool>> &get_command_pools(const Queue &queue, CommandBuffer::ResetMode reset_mode);
 
+	/**
+	 * @brief Requests a descriptor set by key, stamping its use and indexing it by image view if it is created
+	 */
+	DescriptorSet &request_hashed_descriptor_set(std::size_t                               hash,
+	                                             DescriptorSetLayout &                     descriptor_set_layout,
+	                                             DescriptorPool &                          descriptor_pool,
+	                                             const BindingMap<VkDescriptorBufferInfo> &buffer_infos,
+	                                             const BindingMap<VkDescriptorImageInfo> & image_infos,
+	                                             size_t                                    thread_index);
+
+	/**
+	 * @brief Frees the descriptor sets of all threads referring to any of the given image views
+	 */
+	void release_descriptor_sets(const std::vector<core::ImageView> &image_views);
+
 	/// Commands pools associated to the frame
 	std::map<uint32_t, std::vector<std::unique_ptr<CommandPool>>> command_pools;
 
@@ -164,6 +222,17 @@ class RenderFrame
 	/// Descriptor sets for the frame
 	std::vector<std::unique_ptr<std::unordered_map<std::size_t, DescriptorSet>>> descriptor_sets;
 
+	/// Last use of the descriptor sets of each thread
+	std::vector<ResourceCacheLru> descriptor_set_lrus;
+
+	/// Descriptor sets of each thread indexed by the image views they refer to
+	std::vector<DescriptorSetImageViewIndex> image_view_indices;
+
+	ResourceCacheLimits descriptor_set_limits;
+
+	/// Number of times the frame was reset, stamping the descriptor sets it uses
+	uint64_t frame_index{0};
+
 	FencePool fence_pool;
 
 	SemaphorePool semaphore_pool;
@@ -175,5 +244,8 @@ class RenderFrame
 	BufferAllocationStrategy buffer_allocation_strategy{BufferAllocationStrategy::MultipleAllocationsPerBuffer};
 
 	std::map<VkBufferUsageFlags, std::vector<std::pair<BufferPool, BufferBlock *>>> buffer_pools;
+
+	/// Rings used by the RingBuffer strategy, their buffers are only created on the first allocation
+	std::map<VkBufferUsageFlags, std::vector<std::shared_ptr<BufferRing>>> buffer_rings;
 };
 }        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "render_pipeline.h"
 
+#include <ctpl_stl.h>
+
 #include "scene_graph/components/camera.h"
 #include "scene_graph/components/image.h"
 #include "scene_graph/components/material.h"
@@ -26,6 +28,7 @@
 #include "scene_graph/components/sub_mesh.h"
 #include "scene_graph/components/texture.h"
 #include "scene_graph/node.h"
+#include "timer.h"
 
 namespace vkb
 {
@@ -78,6 +81,46 @@ void RenderPipeline::set_clear_value(const std::vector<VkClearValue> &cv)
 	clear_value = cv;
 }
 
+void RenderPipeline::prewarm(RenderTarget &render_target)
+{
+	assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
+
+	auto &device = subpasses.front()->get_render_context().get_device();
+
+	// Request the same render pass the command buffer begins in draw()
+	std::vector<SubpassInfo> subpass_infos(subpasses.size());
+	auto                     subpass_info_it = subpass_infos.begin();
+	for (auto &subpass : subpasses)
+	{
+		subpass_info_it->input_attachments                = subpass->get_input_attachments();
+		subpass_info_it->output_attachments               = subpass->get_output_attachments();
+		subpass_info_it->color_resolve_attachments        = subpass->get_color_resolve_attachments();
+		subpass_info_it->disable_depth_stencil_attachment = subpass->get_disable_depth_stencil_attachment();
+		subpass_info_it->depth_stencil_resolve_mode       = subpass->get_depth_stencil_resolve_mode();
+		subpass_info_it->depth_stencil_resolve_attachment = subpass->get_depth_stencil_resolve_attachment();
+
+		++subpass_info_it;
+	}
+
+	auto &render_pass = device.get_resource_cache().request_render_pass(render_target.get_attachments(), load_store, subpass_infos);
+
+	Timer timer;
+	timer.start();
+
+	auto thread_count = std::thread::hardware_concurrency();
+	thread_count      = thread_count == 0 ? 1 : thread_count;
+	ctpl::thread_pool thread_pool(thread_count);
+
+	for (size_t i = 0; i < subpasses.size(); ++i)
+	{
+		subpasses[i]->prewarm(render_pass, to_u32(i), thread_pool);
+	}
+
+	auto elapsed_time = timer.stop<Timer::Milliseconds>();
+
+	LOGI("Render pipeline prewarm took {} ms", vkb::to_string(elapsed_time));
+}
+
 void RenderPipeline::draw(CommandBuffer &command_buffer, RenderTarget &render_target, VkSubpassContents contents)
 {
 	assert(!subpasses.empty() && "Render pipeline should contain at least one sub-pass");
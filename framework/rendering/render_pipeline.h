@@ -84,6 +84,13 @@ class RenderPipeline
 
 	std::vector<std::unique_ptr<Subpass>> &get_subpasses();
 
+	/**
+	 * @brief Creates up front the pipelines the subpasses are expected to use, in parallel,
+	 *        so the first frames drawn to a matching render target do not stall on pipeline creation
+	 * @param render_target Render target the pipeline is going to be drawn to
+	 */
+	void prewarm(RenderTarget &render_target);
+
 	/**
 	 * @brief Record draw commands for each Subpass
 	 */
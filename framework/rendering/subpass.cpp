@@ -48,6 +48,10 @@ void Subpass::update_render_target_attachments(RenderTarget &render_target)
 	render_target.set_output_attachments(output_attachments);
 }
 
+void Subpass::prewarm(const RenderPass &render_pass, uint32_t subpass_index, ctpl::thread_pool &thread_pool)
+{
+}
+
 RenderContext &Subpass::get_render_context()
 {
 	return render_context;
@@ -30,9 +30,15 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+namespace ctpl
+{
+class thread_pool;
+}
+
 namespace vkb
 {
 class CommandBuffer;
+class RenderPass;
 
 struct alignas(16) Light
 {
@@ -100,6 +106,16 @@ class Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) = 0;
 
+	/**
+	 * @brief Creates the shader modules, pipeline layouts and graphics pipelines
+	 *        the subpass is expected to request while drawing, so the first frames do not stall on them.
+	 *        The default implementation does nothing.
+	 * @param render_pass Render pass the subpass is drawn in
+	 * @param subpass_index Index of the subpass in the render pass
+	 * @param thread_pool Pool used to create the resources in parallel
+	 */
+	virtual void prewarm(const RenderPass &render_pass, uint32_t subpass_index, ctpl::thread_pool &thread_pool);
+
 	RenderContext &get_render_context();
 
 	const ShaderSource &get_vertex_shader() const;
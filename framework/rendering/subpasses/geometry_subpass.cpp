@@ -16,6 +16,9 @@
  */
 
 #include "rendering/subpasses/geometry_subpass.h"
+
+#include <ctpl_stl.h>
+
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "rendering/render_context.h"
@@ -41,16 +44,31 @@ GeometrySubpass::GeometrySubpass(RenderContext &render_context, ShaderSource &&v
 void GeometrySubpass::prepare()
 {
 	// Build all shader variance upfront
-	auto &device = render_context.get_device();
+	request_shader_variants();
+}
+
+void GeometrySubpass::request_shader_variants()
+{
+	// Compile the shader modules of each distinct variant in parallel
+	std::unordered_map<size_t, const ShaderVariant *> variants;
 	for (auto &mesh : meshes)
 	{
 		for (auto &sub_mesh : mesh->get_submeshes())
 		{
-			auto &variant     = sub_mesh->get_shader_variant();
-			auto &vert_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant);
-			auto &frag_module = device.get_resource_cache().request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant);
+			variants.emplace(sub_mesh->get_shader_variant().get_id(), &sub_mesh->get_shader_variant());
 		}
 	}
+
+	std::vector<ShaderModuleRequest> requests;
+	requests.reserve(variants.size() * 2);
+
+	for (auto &variant_it : variants)
+	{
+		requests.push_back({VK_SHADER_STAGE_VERTEX_BIT, &get_vertex_shader(), *variant_it.second});
+		requests.push_back({VK_SHADER_STAGE_FRAGMENT_BIT, &get_fragment_shader(), *variant_it.second});
+	}
+
+	render_context.get_device().get_resource_cache().request_shader_modules(requests);
 }
 
 void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &opaque_nodes, std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> &transparent_nodes)
@@ -86,6 +104,18 @@ void GeometrySubpass::get_sorted_nodes(std::multimap<float, std::pair<sg::Node *
 }
 
 void GeometrySubpass::draw(CommandBuffer &command_buffer)
+{
+	if (command_caching && command_buffer.get_current_subpass_contents() == VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS)
+	{
+		execute_cached_commands(command_buffer);
+	}
+	else
+	{
+		record_draw_commands(command_buffer);
+	}
+}
+
+void GeometrySubpass::record_draw_commands(CommandBuffer &command_buffer)
 {
 	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> opaque_nodes;
 	std::multimap<float, std::pair<sg::Node *, sg::SubMesh *>> transparent_nodes;
@@ -106,19 +136,7 @@ void GeometrySubpass::draw(CommandBuffer &command_buffer)
 	}
 
 	// Enable alpha blending
-	ColorBlendAttachmentState color_blend_attachment{};
-	color_blend_attachment.blend_enable           = VK_TRUE;
-	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
-	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
-
-	ColorBlendState color_blend_state{};
-	color_blend_state.attachments.resize(get_output_attachments().size());
-	for (auto &it : color_blend_state.attachments)
-	{
-		it = color_blend_attachment;
-	}
-	command_buffer.set_color_blend_state(color_blend_state);
+	command_buffer.set_color_blend_state(get_transparent_color_blend_state());
 
 	command_buffer.set_depth_stencil_state(get_depth_stencil_state());
 
@@ -131,17 +149,184 @@ void GeometrySubpass::draw(CommandBuffer &command_buffer)
 	}
 }
 
+void GeometrySubpass::execute_cached_commands(CommandBuffer &command_buffer)
+{
+	auto &device       = render_context.get_device();
+	auto &render_frame = render_context.get_active_frame();
+	auto  frame_index  = render_context.get_active_frame_index();
+
+	if (cached_commands.size() <= frame_index)
+	{
+		cached_commands.resize(frame_index + 1);
+	}
+
+	auto &cache = cached_commands[frame_index];
+
+	if (cache.render_frame != &render_frame)
+	{
+		// First draw of this frame, or the frame was recreated and its resources with it
+		cache = {};
+
+		cache.render_frame        = &render_frame;
+		cache.command_pool        = std::make_unique<CommandPool>(device, device.get_queue_by_flags(VK_QUEUE_GRAPHICS_BIT, 0).get_family_index(), &render_frame, thread_index);
+		cache.uniform_buffer_pool = std::make_unique<BufferPool>(device, RenderFrame::BUFFER_POOL_BLOCK_SIZE * 1024, VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT);
+	}
+
+	auto key = get_cache_key(command_buffer);
+
+	if (cache.command_buffer == nullptr || cache.key != key)
+	{
+		// The frame fence was waited for, so the previous commands of this frame are no longer in use
+		cache.command_pool->reset_pool();
+		cache.uniform_buffer_pool->reset();
+		cache.uniform_buffer_block = nullptr;
+
+		cache.command_buffer = &cache.command_pool->request_command_buffer(VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+		cache.command_buffer->begin(VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT, &command_buffer);
+		cache.command_buffer->inherit_state(command_buffer);
+
+		recording_commands = &cache;
+		record_draw_commands(*cache.command_buffer);
+		recording_commands = nullptr;
+
+		cache.command_buffer->end();
+
+		cache.key = key;
+	}
+
+	command_buffer.execute_commands(*cache.command_buffer);
+}
+
+size_t GeometrySubpass::get_cache_key(CommandBuffer &command_buffer)
+{
+	size_t key = 0;
+
+	hash_combine(key, cache_generation);
+	hash_combine(key, command_buffer.get_state_hash());
+	hash_combine(key, get_vertex_shader().get_id());
+	hash_combine(key, get_fragment_shader().get_id());
+	hash_combine(key, sample_count);
+
+	hash_combine(key, camera.get_view());
+	hash_combine(key, camera.get_projection());
+	hash_combine(key, camera.get_pre_rotation());
+
+	for (auto &mesh : meshes)
+	{
+		for (auto &node : mesh->get_nodes())
+		{
+			hash_combine(key, node->get_transform().get_world_matrix());
+		}
+	}
+
+	return key;
+}
+
+void GeometrySubpass::prewarm(const RenderPass &render_pass, uint32_t subpass_index, ctpl::thread_pool &thread_pool)
+{
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	request_shader_variants();
+
+	// Collect the distinct pipeline states draw() is going to request.
+	// Pipeline layouts are requested on this thread, as setting the resource modes modifies the shared shader modules
+	ColorBlendState opaque_color_blend_state{};
+	opaque_color_blend_state.attachments.resize(render_pass.get_color_output_count(subpass_index));
+
+	ColorBlendState transparent_color_blend_state = get_transparent_color_blend_state();
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+
+	std::unordered_map<size_t, PipelineState> pipeline_states;
+
+	for (auto &mesh : meshes)
+	{
+		// Opaque submeshes are drawn with the winding order of each node using the mesh
+		std::set<VkFrontFace> front_faces;
+		for (auto &node : mesh->get_nodes())
+		{
+			const auto &scale   = node->get_transform().get_scale();
+			bool        flipped = scale.x * scale.y * scale.z < 0;
+			front_faces.insert(flipped ? VK_FRONT_FACE_CLOCKWISE : VK_FRONT_FACE_COUNTER_CLOCKWISE);
+		}
+
+		if (front_faces.empty())
+		{
+			continue;
+		}
+
+		for (auto &sub_mesh : mesh->get_submeshes())
+		{
+			auto &variant = sub_mesh->get_shader_variant();
+
+			std::vector<ShaderModule *> shader_modules{&resource_cache.request_shader_module(VK_SHADER_STAGE_VERTEX_BIT, get_vertex_shader(), variant),
+			                                           &resource_cache.request_shader_module(VK_SHADER_STAGE_FRAGMENT_BIT, get_fragment_shader(), variant)};
+
+			for (auto &shader_module : shader_modules)
+			{
+				for (auto &resource_mode : resource_mode_map)
+				{
+					shader_module->set_resource_mode(resource_mode.first, resource_mode.second);
+				}
+			}
+
+			auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_modules);
+
+			PipelineState pipeline_state;
+			pipeline_state.set_pipeline_layout(pipeline_layout);
+			pipeline_state.set_render_pass(render_pass);
+			pipeline_state.set_subpass_index(subpass_index);
+			pipeline_state.set_multisample_state(multisample_state);
+			pipeline_state.set_vertex_input_state(get_vertex_input_state(pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT), *sub_mesh));
+
+			auto material = sub_mesh->get_material();
+
+			if (material->alpha_mode == sg::AlphaMode::Blend)
+			{
+				pipeline_state.set_color_blend_state(transparent_color_blend_state);
+				pipeline_state.set_depth_stencil_state(get_depth_stencil_state());
+				pipeline_state.set_rasterization_state(get_rasterization_state(VK_FRONT_FACE_COUNTER_CLOCKWISE, material->double_sided));
+				pipeline_states.emplace(pipeline_state.get_hash(), pipeline_state);
+				continue;
+			}
+
+			pipeline_state.set_color_blend_state(opaque_color_blend_state);
+
+			for (auto front_face : front_faces)
+			{
+				pipeline_state.set_rasterization_state(get_rasterization_state(front_face, material->double_sided));
+				pipeline_states.emplace(pipeline_state.get_hash(), pipeline_state);
+			}
+		}
+	}
+
+	// Distinct pipelines are built concurrently by the resource cache
+	std::vector<std::future<void>> pipeline_futures;
+	for (auto &pipeline_state_it : pipeline_states)
+	{
+		auto pipeline_state = &pipeline_state_it.second;
+
+		pipeline_futures.push_back(thread_pool.push([&resource_cache, pipeline_state](size_t) {
+			resource_cache.request_graphics_pipeline(*pipeline_state);
+		}));
+	}
+
+	for (auto &future : pipeline_futures)
+	{
+		future.get();
+	}
+}
+
 void GeometrySubpass::update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index)
 {
 	GlobalUniform global_uniform;
 
 	global_uniform.camera_view_proj = camera.get_pre_rotation() * vkb::vulkan_style_projection(camera.get_projection()) * camera.get_view();
 
-	auto &render_frame = get_render_context().get_active_frame();
-
 	auto &transform = node.get_transform();
 
-	auto allocation = render_frame.allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, sizeof(GlobalUniform), thread_index);
+	auto allocation = allocate_uniform_buffer(sizeof(GlobalUniform), thread_index);
 
 	global_uniform.model = transform.get_world_matrix();
 
@@ -190,33 +375,7 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 
 	auto vertex_input_resources = pipeline_layout.get_resources(ShaderResourceType::Input, VK_SHADER_STAGE_VERTEX_BIT);
 
-	VertexInputState vertex_input_state;
-
-	for (auto &input_resource : vertex_input_resources)
-	{
-		sg::VertexAttribute attribute;
-
-		if (!sub_mesh.get_attribute(input_resource.name, attribute))
-		{
-			continue;
-		}
-
-		VkVertexInputAttributeDescription vertex_attribute{};
-		vertex_attribute.binding  = input_resource.location;
-		vertex_attribute.format   = attribute.format;
-		vertex_attribute.location = input_resource.location;
-		vertex_attribute.offset   = attribute.offset;
-
-		vertex_input_state.attributes.push_back(vertex_attribute);
-
-		VkVertexInputBindingDescription vertex_binding{};
-		vertex_binding.binding = input_resource.location;
-		vertex_binding.stride  = attribute.stride;
-
-		vertex_input_state.bindings.push_back(vertex_binding);
-	}
-
-	command_buffer.set_vertex_input_state(vertex_input_state);
+	command_buffer.set_vertex_input_state(get_vertex_input_state(vertex_input_resources, sub_mesh));
 
 	// Find submesh vertex buffers matching the shader input attribute names
 	for (auto &input_resource : vertex_input_resources)
@@ -237,6 +396,15 @@ void GeometrySubpass::draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &s
 }
 
 void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material)
+{
+	command_buffer.set_rasterization_state(get_rasterization_state(front_face, double_sided_material));
+
+	MultisampleState multisample_state{};
+	multisample_state.rasterization_samples = sample_count;
+	command_buffer.set_multisample_state(multisample_state);
+}
+
+RasterizationState GeometrySubpass::get_rasterization_state(VkFrontFace front_face, bool double_sided_material) const
 {
 	RasterizationState rasterization_state = base_rasterization_state;
 	rasterization_state.front_face = front_face;
@@ -246,11 +414,56 @@ void GeometrySubpass::prepare_pipeline_state(CommandBuffer &command_buffer, VkFr
 		rasterization_state.cull_mode = VK_CULL_MODE_NONE;
 	}
 
-	command_buffer.set_rasterization_state(rasterization_state);
+	return rasterization_state;
+}
 
-	MultisampleState multisample_state{};
-	multisample_state.rasterization_samples = sample_count;
-	command_buffer.set_multisample_state(multisample_state);
+ColorBlendState GeometrySubpass::get_transparent_color_blend_state() const
+{
+	ColorBlendAttachmentState color_blend_attachment{};
+	color_blend_attachment.blend_enable           = VK_TRUE;
+	color_blend_attachment.src_color_blend_factor = VK_BLEND_FACTOR_SRC_ALPHA;
+	color_blend_attachment.dst_color_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+	color_blend_attachment.src_alpha_blend_factor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+
+	ColorBlendState color_blend_state{};
+	color_blend_state.attachments.resize(get_output_attachments().size());
+	for (auto &it : color_blend_state.attachments)
+	{
+		it = color_blend_attachment;
+	}
+
+	return color_blend_state;
+}
+
+VertexInputState GeometrySubpass::get_vertex_input_state(const std::vector<ShaderResource> &vertex_input_resources, const sg::SubMesh &sub_mesh) const
+{
+	VertexInputState vertex_input_state;
+
+	for (auto &input_resource : vertex_input_resources)
+	{
+		sg::VertexAttribute attribute;
+
+		if (!sub_mesh.get_attribute(input_resource.name, attribute))
+		{
+			continue;
+		}
+
+		VkVertexInputAttributeDescription vertex_attribute{};
+		vertex_attribute.binding  = input_resource.location;
+		vertex_attribute.format   = attribute.format;
+		vertex_attribute.location = input_resource.location;
+		vertex_attribute.offset   = attribute.offset;
+
+		vertex_input_state.attributes.push_back(vertex_attribute);
+
+		VkVertexInputBindingDescription vertex_binding{};
+		vertex_binding.binding = input_resource.location;
+		vertex_binding.stride  = attribute.stride;
+
+		vertex_input_state.bindings.push_back(vertex_binding);
+	}
+
+	return vertex_input_state;
 }
 
 PipelineLayout &GeometrySubpass::prepare_pipeline_layout(CommandBuffer &command_buffer, const std::vector<ShaderModule *> &shader_modules)
@@ -306,4 +519,45 @@ void GeometrySubpass::set_thread_index(uint32_t index)
 {
 	thread_index = index;
 }
+
+void GeometrySubpass::set_command_caching(bool enable)
+{
+	command_caching = enable;
+
+	if (!command_caching)
+	{
+		cached_commands.clear();
+	}
+}
+
+void GeometrySubpass::invalidate_cached_commands()
+{
+	++cache_generation;
+}
+
+BufferAllocation GeometrySubpass::allocate_uniform_buffer(VkDeviceSize size, size_t thread_index)
+{
+	if (recording_commands == nullptr)
+	{
+		return render_context.get_active_frame().allocate_buffer(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT, size, thread_index);
+	}
+
+	auto &buffer_block = recording_commands->uniform_buffer_block;
+
+	if (!buffer_block)
+	{
+		buffer_block = &recording_commands->uniform_buffer_pool->request_buffer_block(size);
+	}
+
+	auto allocation = buffer_block->allocate(to_u32(size));
+
+	if (allocation.empty())
+	{
+		buffer_block = &recording_commands->uniform_buffer_pool->request_buffer_block(size);
+
+		allocation = buffer_block->allocate(to_u32(size));
+	}
+
+	return allocation;
+}
 }        // namespace vkb
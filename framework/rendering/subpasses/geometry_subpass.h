@@ -23,6 +23,7 @@ VKBP_DISABLE_WARNINGS()
 #include "common/glm_common.h"
 VKBP_ENABLE_WARNINGS()
 
+#include "core/command_pool.h"
 #include "rendering/subpass.h"
 
 namespace vkb
@@ -85,18 +86,64 @@ class GeometrySubpass : public Subpass
 	 */
 	virtual void draw(CommandBuffer &command_buffer) override;
 
+	/**
+	 * @brief Creates the pipelines of the scene submeshes, using the winding order of the nodes
+	 *        for opaque submeshes and the alpha blended state for transparent ones.
+	 *        Subclasses overriding the pipeline state or layout hooks should override it as well.
+	 */
+	virtual void prewarm(const RenderPass &render_pass, uint32_t subpass_index, ctpl::thread_pool &thread_pool) override;
+
 	/**
 	 * @brief Thread index to use for allocating resources
 	 */
 	void set_thread_index(uint32_t index);
 
+	/**
+	 * @brief Sets whether the draw commands are recorded once into a secondary command buffer per frame,
+	 *        and replayed while the render target, the camera, the node transforms and the state set up
+	 *        by the primary command buffer do not change. It is only used when the subpass contents
+	 *        are provided by secondary command buffers, the commands are recorded inline otherwise
+	 * @param enable Whether to cache the draw commands
+	 */
+	void set_command_caching(bool enable);
+
+	/**
+	 * @brief Records the cached draw commands again on the next draw of each frame,
+	 *        for the changes the cache does not detect, such as materials, meshes or pipeline states
+	 */
+	void invalidate_cached_commands();
+
   protected:
+	/**
+	 * @brief Allocates a uniform buffer for the draw commands. While they are recorded for the
+	 *        command cache, it comes from a buffer pool kept until they are recorded again,
+	 *        so overrides of update_uniform must use it for the cached commands to stay valid
+	 */
+	BufferAllocation allocate_uniform_buffer(VkDeviceSize size, size_t thread_index = 0);
+
+	/**
+	 * @brief Compiles the shader modules of all the submesh variants in parallel
+	 */
+	void request_shader_variants();
+
 	virtual void update_uniform(CommandBuffer &command_buffer, sg::Node &node, size_t thread_index = 0);
 
 	void draw_submesh(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh, VkFrontFace front_face = VK_FRONT_FACE_COUNTER_CLOCKWISE);
 
 	virtual void prepare_pipeline_state(CommandBuffer &command_buffer, VkFrontFace front_face, bool double_sided_material);
 
+	RasterizationState get_rasterization_state(VkFrontFace front_face, bool double_sided_material) const;
+
+	/**
+	 * @brief Color blend state used to draw transparent objects
+	 */
+	ColorBlendState get_transparent_color_blend_state() const;
+
+	/**
+	 * @brief Matches the vertex shader inputs with the attributes of a submesh
+	 */
+	VertexInputState get_vertex_input_state(const std::vector<ShaderResource> &vertex_input_resources, const sg::SubMesh &sub_mesh) const;
+
 	virtual PipelineLayout &prepare_pipeline_layout(CommandBuffer &command_buffer, const std::vector<ShaderModule *> &shader_modules);
 
 	virtual void prepare_push_constants(CommandBuffer &command_buffer, sg::SubMesh &sub_mesh);
@@ -119,6 +166,51 @@ class GeometrySubpass : public Subpass
 	uint32_t thread_index{0};
 
 	vkb::RasterizationState base_rasterization_state{};
+
+  private:
+	/**
+	 * @brief Draw commands cached for a render frame, with the resources they use
+	 */
+	struct CachedCommands
+	{
+		RenderFrame *render_frame{nullptr};
+
+		std::unique_ptr<CommandPool> command_pool;
+
+		CommandBuffer *command_buffer{nullptr};
+
+		std::unique_ptr<BufferPool> uniform_buffer_pool;
+
+		BufferBlock *uniform_buffer_block{nullptr};
+
+		size_t key{0};
+	};
+
+	/**
+	 * @brief Records the draw commands of the scene
+	 */
+	void record_draw_commands(CommandBuffer &command_buffer);
+
+	/**
+	 * @brief Executes the cached draw commands of the active frame, recording them again if they are outdated
+	 */
+	void execute_cached_commands(CommandBuffer &command_buffer);
+
+	/**
+	 * @return A hash of everything the cached draw commands depend on and are checked against
+	 */
+	size_t get_cache_key(CommandBuffer &command_buffer);
+
+	bool command_caching{false};
+
+	/// Incremented to invalidate the cached commands of all the frames
+	uint64_t cache_generation{0};
+
+	/// Cached commands of each render frame, indexed by frame index
+	std::vector<CachedCommands> cached_commands;
+
+	/// Cached commands being recorded, whose uniform buffers are allocated from their own pool
+	CachedCommands *recording_commands{nullptr};
 };
 
 }        // namespace vkb
@@ -23,118 +23,240 @@ void ResourceBindingState::reset()
 {
 	clear_dirty();
 
-	resource_sets.clear();
+	for (uint32_t set = 0; set < MAX_SETS; ++set)
+	{
+		if (bound_sets & (1u << set))
+		{
+			resource_sets[set].reset();
+		}
+	}
+
+	bound_sets = 0;
 }
 
-bool ResourceBindingState::is_dirty()
+bool ResourceBindingState::is_dirty() const
 {
-	return dirty;
+	return dirty_sets != 0;
 }
 
 void ResourceBindingState::clear_dirty()
 {
-	dirty = false;
+	dirty_sets = 0;
 }
 
-void ResourceBindingState::clear_dirty(uint32_t set)
+void ResourceBindingState::set_dirty()
 {
-	resource_sets[set].clear_dirty();
+	dirty_sets = bound_sets;
+
+	for (auto &resource_set : resource_sets)
+	{
+		resource_set.set_dirty();
+	}
 }
 
 void ResourceBindingState::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_buffer(buffer, offset, range, binding, array_element);
-
-	dirty = true;
+	begin_bind(set).bind_buffer(buffer, offset, range, binding, array_element);
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, sampler, binding, array_element);
-
-	dirty = true;
+	begin_bind(set).bind_image(image_view, sampler, binding, array_element);
 }
 
 void ResourceBindingState::bind_image(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_image(image_view, binding, array_element);
-
-	dirty = true;
+	begin_bind(set).bind_image(image_view, binding, array_element);
 }
 
 void ResourceBindingState::bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element)
 {
-	resource_sets[set].bind_input(image_view, binding, array_element);
+	begin_bind(set).bind_input(image_view, binding, array_element);
+}
+
+uint32_t ResourceBindingState::get_bound_sets() const
+{
+	return bound_sets;
+}
+
+uint32_t ResourceBindingState::get_dirty_sets() const
+{
+	return dirty_sets;
+}
+
+ResourceSet &ResourceBindingState::get_resource_set(uint32_t set)
+{
+	return resource_sets.at(set);
+}
 
-	dirty = true;
+const ResourceSet &ResourceBindingState::get_resource_set(uint32_t set) const
+{
+	return resource_sets.at(set);
 }
 
-const std::unordered_map<uint32_t, ResourceSet> &ResourceBindingState::get_resource_sets()
+ResourceSet &ResourceBindingState::begin_bind(uint32_t set)
 {
-	return resource_sets;
+	if (set >= MAX_SETS)
+	{
+		throw std::runtime_error{"Descriptor set " + std::to_string(set) + " is out of the bounds of the resource binding state"};
+	}
+
+	bound_sets |= 1u << set;
+	dirty_sets |= 1u << set;
+
+	return resource_sets[set];
 }
 
 void ResourceSet::reset()
 {
 	clear_dirty();
 
-	resource_bindings.clear();
+	// The bindings are emptied when they are bound again
+	bound_bindings = 0;
 }
 
 bool ResourceSet::is_dirty() const
 {
-	return dirty;
+	return dirty_bindings != 0;
 }
 
 void ResourceSet::clear_dirty()
 {
-	dirty = false;
+	dirty_bindings = 0;
 }
 
-void ResourceSet::clear_dirty(uint32_t binding, uint32_t array_element)
+void ResourceSet::set_dirty()
 {
-	resource_bindings[binding][array_element].dirty = false;
+	dirty_bindings = bound_bindings;
 }
 
 void ResourceSet::bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty  = true;
-	resource_bindings[binding][array_element].buffer = &buffer;
-	resource_bindings[binding][array_element].offset = offset;
-	resource_bindings[binding][array_element].range  = range;
+	auto &resource_info = begin_bind(binding, array_element);
+
+	resource_info.buffer = &buffer;
+	resource_info.offset = offset;
+	resource_info.range  = range;
 
-	dirty = true;
+	toggle_resource_hash(binding, array_element);
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, const core::Sampler &sampler, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = &sampler;
+	auto &resource_info = begin_bind(binding, array_element);
+
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = &sampler;
 
-	dirty = true;
+	toggle_resource_hash(binding, array_element);
 }
 
 void ResourceSet::bind_image(const core::ImageView &image_view, uint32_t binding, uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
-	resource_bindings[binding][array_element].sampler    = nullptr;
+	auto &resource_info = begin_bind(binding, array_element);
 
-	dirty = true;
+	resource_info.image_view = &image_view;
+	resource_info.sampler    = nullptr;
+
+	toggle_resource_hash(binding, array_element);
 }
 
 void ResourceSet::bind_input(const core::ImageView &image_view, const uint32_t binding, const uint32_t array_element)
 {
-	resource_bindings[binding][array_element].dirty      = true;
-	resource_bindings[binding][array_element].image_view = &image_view;
+	auto &resource_info = begin_bind(binding, array_element);
+
+	resource_info.image_view = &image_view;
+
+	toggle_resource_hash(binding, array_element);
+}
 
-	dirty = true;
+uint32_t ResourceSet::get_bound_bindings() const
+{
+	return bound_bindings;
 }
 
-const BindingMap<ResourceInfo> &ResourceSet::get_resource_bindings() const
+uint32_t ResourceSet::get_dirty_bindings() const
 {
-	return resource_bindings;
+	return dirty_bindings;
 }
 
+uint32_t ResourceSet::get_bound_elements(uint32_t binding) const
+{
+	return bindings.at(binding).bound_elements;
+}
+
+const ResourceInfo &ResourceSet::get_resource(uint32_t binding, uint32_t array_element) const
+{
+	return bindings.at(binding).resources.at(array_element);
+}
+
+size_t ResourceSet::get_binding_hash(uint32_t binding, bool include_offsets) const
+{
+	if (binding >= MAX_BINDINGS || !(bound_bindings & (1u << binding)))
+	{
+		return 0;
+	}
+
+	return include_offsets ? bindings[binding].hash_with_offsets : bindings[binding].hash_without_offsets;
+}
+
+ResourceInfo &ResourceSet::begin_bind(uint32_t binding, uint32_t array_element)
+{
+	if (binding >= MAX_BINDINGS || array_element >= MAX_ARRAY_ELEMENTS)
+	{
+		throw std::runtime_error{"Binding " + std::to_string(binding) + " array element " + std::to_string(array_element) + " is out of the bounds of the resource set"};
+	}
+
+	auto &binding_state = bindings[binding];
+
+	if (!(bound_bindings & (1u << binding)))
+	{
+		binding_state.bound_elements       = 0;
+		binding_state.hash_with_offsets    = 0;
+		binding_state.hash_without_offsets = 0;
+	}
+
+	if (binding_state.bound_elements & (1u << array_element))
+	{
+		toggle_resource_hash(binding, array_element);
+	}
+	else
+	{
+		binding_state.resources[array_element] = {};
+		binding_state.bound_elements |= 1u << array_element;
+	}
+
+	bound_bindings |= 1u << binding;
+	dirty_bindings |= 1u << binding;
+
+	return binding_state.resources[array_element];
+}
+
+void ResourceSet::toggle_resource_hash(uint32_t binding, uint32_t array_element)
+{
+	auto &binding_state = bindings[binding];
+	auto &resource_info = binding_state.resources[array_element];
+
+	// Empty resources do not contribute to the hash
+	if (!resource_info.buffer && !resource_info.image_view && !resource_info.sampler)
+	{
+		return;
+	}
+
+	size_t resource_hash{0};
+
+	// Terms of different bindings and array elements never cancel each other out
+	hash_combine(resource_hash, binding);
+	hash_combine(resource_hash, array_element);
+	hash_combine(resource_hash, resource_info.buffer ? resource_info.buffer->get_handle() : VK_NULL_HANDLE);
+	hash_combine(resource_hash, resource_info.range);
+	hash_combine(resource_hash, resource_info.image_view ? resource_info.image_view->get_handle() : VK_NULL_HANDLE);
+	hash_combine(resource_hash, resource_info.sampler ? resource_info.sampler->get_handle() : VK_NULL_HANDLE);
+
+	binding_state.hash_without_offsets ^= resource_hash;
+
+	hash_combine(resource_hash, resource_info.offset);
+
+	binding_state.hash_with_offsets ^= resource_hash;
+}
 }        // namespace vkb
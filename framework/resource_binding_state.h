@@ -17,6 +17,8 @@
 
 #pragma once
 
+#include <array>
+
 #include "common/vk_common.h"
 #include "core/buffer.h"
 #include "core/image_view.h"
@@ -31,8 +33,6 @@ namespace vkb
  */
 struct ResourceInfo
 {
-	bool dirty{false};
-
 	const core::Buffer *buffer{nullptr};
 
 	VkDeviceSize offset{0};
@@ -49,17 +49,26 @@ struct ResourceInfo
  *        by a command buffer.
  *
  * The ResourceSet has a one to one mapping with a DescriptorSet.
+ * Resources are stored in a fixed-size table indexed by binding and array element,
+ * with bitmasks of the bound and dirty bindings, so binding resources never allocates memory.
  */
 class ResourceSet
 {
   public:
+	/// Number of bindings of a set which can be bound by a command buffer
+	static constexpr uint32_t MAX_BINDINGS = 32;
+
+	/// Number of array elements of a binding which can be bound by a command buffer
+	static constexpr uint32_t MAX_ARRAY_ELEMENTS = 4;
+
 	void reset();
 
 	bool is_dirty() const;
 
 	void clear_dirty();
 
-	void clear_dirty(uint32_t binding, uint32_t array_element);
+	/// @brief Flags all the bound bindings as changed, so that they are written again
+	void set_dirty();
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t binding, uint32_t array_element);
 
@@ -69,12 +78,58 @@ class ResourceSet
 
 	void bind_input(const core::ImageView &image_view, uint32_t binding, uint32_t array_element);
 
-	const BindingMap<ResourceInfo> &get_resource_bindings() const;
+	/**
+	 * @return A bitmask of the bindings with at least one bound resource
+	 */
+	uint32_t get_bound_bindings() const;
+
+	/**
+	 * @return A bitmask of the bindings whose resources changed since the last call to clear_dirty
+	 */
+	uint32_t get_dirty_bindings() const;
+
+	/**
+	 * @return A bitmask of the bound array elements of a binding
+	 */
+	uint32_t get_bound_elements(uint32_t binding) const;
+
+	const ResourceInfo &get_resource(uint32_t binding, uint32_t array_element) const;
+
+	/**
+	 * @brief Returns a hash of the resources bound to a binding, updated whenever one of them is bound
+	 * @param binding The binding index
+	 * @param include_offsets False to ignore buffer offsets, as for dynamic buffers whose offsets are given when binding the set
+	 */
+	size_t get_binding_hash(uint32_t binding, bool include_offsets) const;
 
   private:
-	bool dirty{false};
+	/// Resources bound to a binding, and hashes of those resources combined with XOR so that a single resource can be replaced.
+	/// Each term is seeded with its binding and array element, and the descriptor set found with the hash is checked against the resources.
+	struct Binding
+	{
+		std::array<ResourceInfo, MAX_ARRAY_ELEMENTS> resources;
+
+		uint32_t bound_elements{0};
+
+		size_t hash_with_offsets{0};
+
+		size_t hash_without_offsets{0};
+	};
 
-	BindingMap<ResourceInfo> resource_bindings;
+	/**
+	 * @brief Gets the resource at a binding and array element, emptied if it was not bound yet,
+	 *        and removes it from the hash of its binding until it is bound again with toggle_resource_hash
+	 */
+	ResourceInfo &begin_bind(uint32_t binding, uint32_t array_element);
+
+	/// @brief Adds the hash of a resource to the hash of its binding, or removes it if it was already added
+	void toggle_resource_hash(uint32_t binding, uint32_t array_element);
+
+	std::array<Binding, MAX_BINDINGS> bindings;
+
+	uint32_t bound_bindings{0};
+
+	uint32_t dirty_bindings{0};
 };
 
 /**
@@ -86,13 +141,17 @@ class ResourceSet
 class ResourceBindingState
 {
   public:
+	/// Number of descriptor sets which can be bound by a command buffer, the minimum guaranteed by Vulkan
+	static constexpr uint32_t MAX_SETS = 4;
+
 	void reset();
 
-	bool is_dirty();
+	bool is_dirty() const;
 
 	void clear_dirty();
 
-	void clear_dirty(uint32_t set);
+	/// @brief Flags all the bound sets as changed, so that they are bound again
+	void set_dirty();
 
 	void bind_buffer(const core::Buffer &buffer, VkDeviceSize offset, VkDeviceSize range, uint32_t set, uint32_t binding, uint32_t array_element);
 
@@ -102,11 +161,28 @@ class ResourceBindingState
 
 	void bind_input(const core::ImageView &image_view, uint32_t set, uint32_t binding, uint32_t array_element);
 
-	const std::unordered_map<uint32_t, ResourceSet> &get_resource_sets();
+	/**
+	 * @return A bitmask of the sets with at least one bound resource
+	 */
+	uint32_t get_bound_sets() const;
+
+	/**
+	 * @return A bitmask of the sets whose resources changed since the last call to clear_dirty
+	 */
+	uint32_t get_dirty_sets() const;
+
+	ResourceSet &get_resource_set(uint32_t set);
+
+	const ResourceSet &get_resource_set(uint32_t set) const;
 
   private:
-	bool dirty{false};
+	/// @brief Gets a resource set to bind resources to, and flags it as bound and dirty
+	ResourceSet &begin_bind(uint32_t set);
+
+	std::array<ResourceSet, MAX_SETS> resource_sets;
+
+	uint32_t bound_sets{0};
 
-	std::unordered_map<uint32_t, ResourceSet> resource_sets;
+	uint32_t dirty_sets{0};
 };
 }        // namespace vkb
@@ -17,34 +17,442 @@
 
 #include "resource_cache.h"
 
+#include <algorithm>
+#include <map>
+
+#include <ctpl_stl.h>
+
 #include "common/resource_caching.h"
 #include "core/device.h"
+#include "glsl_compiler.h"
+#include "timer.h"
 
 namespace vkb
 {
 namespace
 {
+/// Set on the threads of the compile pool by the jobs they run, the pool threads never run other jobs
+thread_local bool is_compile_worker{false};
+
+/**
+ * @brief Records a resource created by the warmup replay the first time it is requested again,
+ *        so that the saved warmup file only holds the resources used by the session
+ */
 template <class T, class... A>
-T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, A &... args)
+void record_replayed_resource(ResourceRecord &recorder, T &resource, A &... args)
 {
+	if (recorder.take_replayed(&resource))
+	{
+		RecordHelper<T, A...> record_helper;
+
+		size_t index = record_helper.record(recorder, args...);
+		record_helper.index(recorder, index, resource);
+	}
+}
+
+template <class T, class... A>
+T &request_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
 	std::lock_guard<std::mutex> guard(resource_mutex);
 
-	auto &res = request_resource(device, &recorder, resources, args...);
+	auto res_it = resources.find(hash);
+
+	if (res_it != resources.end())
+	{
+		counters.add_hit();
+		record_replayed_resource(recorder, res_it->second, args...);
+		return res_it->second;
+	}
+
+	Timer timer;
+	timer.start();
+
+	bool replaying = recorder.is_replaying();
+
+	auto &res = request_hashed_resource(device, replaying ? nullptr : &recorder, resources, hash, args...);
+
+	if (replaying)
+	{
+		recorder.add_replayed(&res);
+	}
+
+	counters.add_miss(timer.stop<Timer::Milliseconds>());
 
 	return res;
 }
+
+/**
+ * @brief Builds a resource which has been registered as pending and moves it into the cache.
+ *        The resource mutex is only held to insert the result, not during creation.
+ *        Threads waiting on the pending future receive the resource or the creation error.
+ */
+template <class T, class... A>
+T &build_pending_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters, std::unordered_map<std::size_t, std::shared_future<T *>> &pending_resources, std::size_t hash, std::promise<T *> &promise, A &... args)
+{
+	const char *res_type = typeid(T).name();
+
+	LOGD("Building pending cache object ({})", res_type);
+
+	T *res_ptr{nullptr};
+
+	try
+	{
+		Timer timer;
+		timer.start();
+
+		T resource(device, args...);
+
+		counters.add_miss(timer.stop<Timer::Milliseconds>());
+
+		std::lock_guard<std::mutex> guard(resource_mutex);
+
+		auto res_it = resources.emplace(hash, std::move(resource)).first;
+
+		if (recorder.is_replaying())
+		{
+			recorder.add_replayed(&res_it->second);
+		}
+		else
+		{
+			RecordHelper<T, A...> record_helper;
+
+			size_t index = record_helper.record(recorder, args...);
+			record_helper.index(recorder, index, res_it->second);
+		}
+
+		pending_resources.erase(hash);
+
+		res_ptr = &res_it->second;
+	}
+	catch (...)
+	{
+		LOGE("Creation error for pending cache object ({})", res_type);
+
+		{
+			std::lock_guard<std::mutex> guard(resource_mutex);
+			pending_resources.erase(hash);
+		}
+
+		promise.set_exception(std::current_exception());
+		throw;
+	}
+
+	promise.set_value(res_ptr);
+
+	return *res_ptr;
+}
+
+/**
+ * @brief Requests a resource without holding the resource mutex while it is being built.
+ *        The hash is registered as pending with a shared future, so that distinct resources
+ *        can be compiled in parallel and only requests for the same key wait for it.
+ */
+template <class T, class... A>
+T &request_pending_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters, std::unordered_map<std::size_t, std::shared_future<T *>> &pending_resources, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	std::promise<T *> promise;
+
+	{
+		std::unique_lock<std::mutex> lock(resource_mutex);
+
+		auto res_it = resources.find(hash);
+
+		if (res_it != resources.end())
+		{
+			counters.add_hit();
+			record_replayed_resource(recorder, res_it->second, args...);
+			return res_it->second;
+		}
+
+		// Another thread is already building this resource, wait for it outside the lock
+		auto pending_it = pending_resources.find(hash);
+
+		if (pending_it != pending_resources.end())
+		{
+			counters.add_hit();
+
+			auto pending = pending_it->second;
+			lock.unlock();
+
+			return *pending.get();
+		}
+
+		pending_resources.emplace(hash, promise.get_future().share());
+	}
+
+	return build_pending_resource(device, recorder, resource_mutex, resources, counters, pending_resources, hash, promise, args...);
+}
+
+/**
+ * @brief Requests a resource and stamps it with the current frame, so that it can be evicted once unused
+ * @param on_create Called with the key and the resource when it is created, while holding the resource mutex
+ */
+template <class T, class F, class... A>
+T &request_tracked_resource(Device &device, ResourceRecord &recorder, std::mutex &resource_mutex, std::unordered_map<std::size_t, T> &resources, ResourceCacheCounters &counters, ResourceCacheLru &lru, uint64_t frame_index, F on_create, A &... args)
+{
+	std::size_t hash{0U};
+	hash_param(hash, args...);
+
+	std::lock_guard<std::mutex> guard(resource_mutex);
+
+	lru.touch(hash, frame_index);
+
+	auto res_it = resources.find(hash);
+
+	if (res_it != resources.end())
+	{
+		counters.add_hit();
+		return res_it->second;
+	}
+
+	Timer timer;
+	timer.start();
+
+	auto &resource = request_hashed_resource(device, &recorder, resources, hash, args...);
+
+	counters.add_miss(timer.stop<Timer::Milliseconds>());
+
+	on_create(hash, resource);
+
+	return resource;
+}
+
+/**
+ * @brief Identifies the framework and driver which created a warmup file
+ */
+struct WarmupFileHeader
+{
+	uint32_t magic{0};
+
+	uint32_t version{0};
+
+	uint32_t vendor_id{0};
+
+	uint32_t device_id{0};
+
+	uint32_t driver_version{0};
+
+	std::array<uint8_t, VK_UUID_SIZE> pipeline_cache_uuid{};
+};
+
+const uint32_t WARMUP_FILE_MAGIC = 0x564B4243;        // "VKBC"
+
+WarmupFileHeader get_warmup_file_header(const Device &device)
+{
+	auto properties = device.get_gpu().get_properties();
+
+	WarmupFileHeader header{};
+	header.magic          = WARMUP_FILE_MAGIC;
+	header.version        = ResourceCache::WARMUP_FILE_VERSION;
+	header.vendor_id      = properties.vendorID;
+	header.device_id      = properties.deviceID;
+	header.driver_version = properties.driverVersion;
+
+	std::copy(std::begin(properties.pipelineCacheUUID), std::end(properties.pipelineCacheUUID), header.pipeline_cache_uuid.begin());
+
+	return header;
+}
+
+bool read_blob(std::istringstream &is, std::size_t total_size, std::vector<uint8_t> &value)
+{
+	std::size_t size{0};
+	read(is, size);
+
+	// Check the size before allocating, as it might come from a corrupted file
+	if (!is || size > total_size - static_cast<std::size_t>(is.tellg()))
+	{
+		return false;
+	}
+
+	value.resize(size);
+	is.read(reinterpret_cast<char *>(value.data()), size);
+
+	return static_cast<bool>(is);
+}
 }        // namespace
 
+const std::array<double, ResourceCacheTypeStats::CREATION_TIME_BUCKET_COUNT - 1> ResourceCacheTypeStats::creation_time_bucket_bounds{0.1, 0.5, 1.0, 5.0, 10.0, 50.0, 100.0};
+
+void ResourceCacheCounters::add_hit()
+{
+	++hits;
+}
+
+void ResourceCacheCounters::add_miss(double creation_time)
+{
+	auto &bounds = ResourceCacheTypeStats::creation_time_bucket_bounds;
+	auto  bucket = std::upper_bound(bounds.begin(), bounds.end(), creation_time) - bounds.begin();
+
+	std::lock_guard<std::mutex> guard(creation_mutex);
+
+	++creation_stats.misses;
+	++creation_stats.creation_time_histogram[bucket];
+
+	creation_stats.creation_time += creation_time;
+	creation_stats.max_creation_time = std::max(creation_stats.max_creation_time, creation_time);
+}
+
+ResourceCacheTypeStats ResourceCacheCounters::get_stats() const
+{
+	ResourceCacheTypeStats stats;
+
+	{
+		std::lock_guard<std::mutex> guard(creation_mutex);
+		stats = creation_stats;
+	}
+
+	stats.hits = hits;
+
+	return stats;
+}
+
+void ResourceCacheLru::touch(std::size_t key, uint64_t frame_index)
+{
+	auto position_it = positions.find(key);
+
+	if (position_it != positions.end())
+	{
+		position_it->second->second = frame_index;
+
+		// Move the entry to the most recently used end, without reallocating it
+		entries.splice(entries.end(), entries, position_it->second);
+	}
+	else
+	{
+		positions.emplace(key, entries.emplace(entries.end(), key, frame_index));
+	}
+}
+
+void ResourceCacheLru::rekey(std::size_t old_key, std::size_t new_key)
+{
+	auto position_it = positions.find(old_key);
+
+	if (position_it == positions.end())
+	{
+		return;
+	}
+
+	auto entry_it = position_it->second;
+	positions.erase(position_it);
+
+	// An object already using the new key is replaced
+	erase(new_key);
+
+	entry_it->first    = new_key;
+	positions[new_key] = entry_it;
+}
+
+void ResourceCacheLru::erase(std::size_t key)
+{
+	auto position_it = positions.find(key);
+
+	if (position_it != positions.end())
+	{
+		entries.erase(position_it->second);
+		positions.erase(position_it);
+	}
+}
+
+void ResourceCacheLru::clear()
+{
+	entries.clear();
+	positions.clear();
+}
+
+void DescriptorSetImageViewIndex::add(std::size_t key, DescriptorSet &descriptor_set)
+{
+	for (auto &binding_it : descriptor_set.get_image_infos())
+	{
+		for (auto &element_it : binding_it.second)
+		{
+			if (element_it.second.imageView != VK_NULL_HANDLE)
+			{
+				descriptor_sets[element_it.second.imageView].insert(key);
+			}
+		}
+	}
+}
+
+void DescriptorSetImageViewIndex::remove(std::size_t key, DescriptorSet &descriptor_set)
+{
+	for (auto &binding_it : descriptor_set.get_image_infos())
+	{
+		for (auto &element_it : binding_it.second)
+		{
+			auto index_it = descriptor_sets.find(element_it.second.imageView);
+
+			if (index_it != descriptor_sets.end())
+			{
+				index_it->second.erase(key);
+
+				if (index_it->second.empty())
+				{
+					descriptor_sets.erase(index_it);
+				}
+			}
+		}
+	}
+}
+
+std::vector<std::size_t> DescriptorSetImageViewIndex::take(VkImageView image_view)
+{
+	auto index_it = descriptor_sets.find(image_view);
+
+	if (index_it == descriptor_sets.end())
+	{
+		return {};
+	}
+
+	std::vector<std::size_t> keys(index_it->second.begin(), index_it->second.end());
+	descriptor_sets.erase(index_it);
+
+	return keys;
+}
+
+void DescriptorSetImageViewIndex::clear()
+{
+	descriptor_sets.clear();
+}
+
 ResourceCache::ResourceCache(Device &device) :
     device{device}
 {
 }
 
+ResourceCache::~ResourceCache()
+{
+	// Let background compilations finish before the cached objects are destroyed
+	if (compile_pool)
+	{
+		compile_pool->stop(true);
+	}
+}
+
 void ResourceCache::warmup(const std::vector<uint8_t> &data)
 {
-	recorder.set_data(data);
+	// The replayed resources are only recorded again once the application requests them, after their dependencies,
+	// so that resources which are not used anymore or fail to replay are left out of the saved file
+	recorder.set_data({});
+	recorder.clear_replayed();
+	recorder.set_replaying(true);
+
+	try
+	{
+		replayer.play(*this, data);
+	}
+	catch (...)
+	{
+		recorder.set_replaying(false);
+		throw;
+	}
 
-	replayer.play(*this, recorder);
+	recorder.set_replaying(false);
 }
 
 std::vector<uint8_t> ResourceCache::serialize()
@@ -52,6 +460,76 @@ std::vector<uint8_t> ResourceCache::serialize()
 	return recorder.get_data();
 }
 
+std::vector<uint8_t> ResourceCache::serialize_warmup_file()
+{
+	std::vector<uint8_t> pipeline_cache_data;
+
+	if (pipeline_cache != VK_NULL_HANDLE)
+	{
+		size_t size{};
+		VK_CHECK(vkGetPipelineCacheData(device.get_handle(), pipeline_cache, &size, nullptr));
+
+		pipeline_cache_data.resize(size);
+		VK_CHECK(vkGetPipelineCacheData(device.get_handle(), pipeline_cache, &size, pipeline_cache_data.data()));
+	}
+
+	std::ostringstream stream;
+
+	write(stream,
+	      get_warmup_file_header(device),
+	      pipeline_cache_data,
+	      recorder.get_data());
+
+	std::string str = stream.str();
+
+	return std::vector<uint8_t>{str.begin(), str.end()};
+}
+
+bool ResourceCache::deserialize_warmup_file(const std::vector<uint8_t> &file_data, std::vector<uint8_t> &pipeline_cache_data, std::vector<uint8_t> &resource_data) const
+{
+	WarmupFileHeader header{};
+
+	if (file_data.size() < sizeof(WarmupFileHeader))
+	{
+		LOGW("Warmup file is too small");
+		return false;
+	}
+
+	std::istringstream stream{std::string{file_data.begin(), file_data.end()}};
+
+	read(stream, header);
+
+	auto expected_header = get_warmup_file_header(device);
+
+	if (header.magic != expected_header.magic || header.version != expected_header.version)
+	{
+		LOGW("Warmup file was written by another version of the framework");
+		return false;
+	}
+
+	if (header.vendor_id != expected_header.vendor_id ||
+	    header.device_id != expected_header.device_id ||
+	    header.driver_version != expected_header.driver_version ||
+	    header.pipeline_cache_uuid != expected_header.pipeline_cache_uuid)
+	{
+		LOGW("Warmup file was written for another device or driver");
+		return false;
+	}
+
+	if (!read_blob(stream, file_data.size(), pipeline_cache_data) ||
+	    !read_blob(stream, file_data.size(), resource_data))
+	{
+		LOGW("Warmup file is corrupted");
+
+		pipeline_cache_data.clear();
+		resource_data.clear();
+
+		return false;
+	}
+
+	return true;
+}
+
 void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 {
 	pipeline_cache = new_pipeline_cache;
@@ -60,55 +538,532 @@ void ResourceCache::set_pipeline_cache(VkPipelineCache new_pipeline_cache)
 ShaderModule &ResourceCache::request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant)
 {
 	std::string entry_point{"main"};
-	return request_resource(device, recorder, shader_module_mutex, state.shader_modules, stage, glsl_source, entry_point, shader_variant);
+	return request_pending_resource(device, recorder, shader_module_mutex, state.shader_modules, get_counters(ResourceCacheType::ShaderModule), pending_shader_modules, stage, glsl_source, entry_point, shader_variant);
+}
+
+std::vector<ShaderModule *> ResourceCache::request_shader_modules(const std::vector<ShaderModuleRequest> &requests)
+{
+	// Keep glslang initialized until all the modules are compiled
+	GLSLCompiler::ProcessScope glslang_scope;
+
+	// A compile job waiting for jobs queued behind it would deadlock the pool once all the workers wait, so it compiles the batch itself
+	if (is_compile_worker)
+	{
+		std::vector<ShaderModule *> shader_modules;
+		shader_modules.reserve(requests.size());
+
+		for (auto &request : requests)
+		{
+			shader_modules.push_back(&request_shader_module(request.stage, *request.glsl_source, request.shader_variant));
+		}
+
+		return shader_modules;
+	}
+
+	auto &thread_pool = get_compile_pool();
+
+	std::vector<std::future<ShaderModule *>> futures;
+	futures.reserve(requests.size());
+
+	for (auto &request : requests)
+	{
+		futures.push_back(thread_pool.push([this, &request](size_t) {
+			is_compile_worker = true;
+
+			return &request_shader_module(request.stage, *request.glsl_source, request.shader_variant);
+		}));
+	}
+
+	// Wait for every job before reporting an error, as they refer to the requests
+	std::vector<ShaderModule *> shader_modules;
+	shader_modules.reserve(requests.size());
+
+	std::exception_ptr error;
+
+	for (auto &future : futures)
+	{
+		try
+		{
+			shader_modules.push_back(future.get());
+		}
+		catch (...)
+		{
+			if (!error)
+			{
+				error = std::current_exception();
+			}
+		}
+	}
+
+	if (error)
+	{
+		std::rethrow_exception(error);
+	}
+
+	return shader_modules;
 }
 
 PipelineLayout &ResourceCache::request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
-	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, shader_modules);
+	return request_resource(device, recorder, pipeline_layout_mutex, state.pipeline_layouts, get_counters(ResourceCacheType::PipelineLayout), shader_modules);
 }
 
 DescriptorSetLayout &ResourceCache::request_descriptor_set_layout(const uint32_t                     set_index,
                                                                   const std::vector<ShaderModule *> &shader_modules,
                                                                   const std::vector<ShaderResource> &set_resources)
 {
-	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, set_index, shader_modules, set_resources);
+	return request_resource(device, recorder, descriptor_set_layout_mutex, state.descriptor_set_layouts, get_counters(ResourceCacheType::DescriptorSetLayout), set_index, shader_modules, set_resources);
 }
 
 GraphicsPipeline &ResourceCache::request_graphics_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, pipeline_cache, pipeline_state);
+	return request_pending_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, get_counters(ResourceCacheType::GraphicsPipeline), pending_graphics_pipelines, pipeline_cache, pipeline_state);
+}
+
+GraphicsPipeline *ResourceCache::request_graphics_pipeline_async(PipelineState &pipeline_state)
+{
+	std::size_t hash{0U};
+	hash_param(hash, pipeline_cache, pipeline_state);
+
+	auto promise = std::make_shared<std::promise<GraphicsPipeline *>>();
+
+	{
+		std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+
+		auto res_it = state.graphics_pipelines.find(hash);
+
+		if (res_it != state.graphics_pipelines.end())
+		{
+			get_counters(ResourceCacheType::GraphicsPipeline).add_hit();
+			record_replayed_resource(recorder, res_it->second, pipeline_cache, pipeline_state);
+			return &res_it->second;
+		}
+
+		// Already queued or being built by another thread
+		if (pending_graphics_pipelines.find(hash) != pending_graphics_pipelines.end())
+		{
+			return nullptr;
+		}
+
+		// Building it again would fail again, on every draw
+		if (failed_graphics_pipelines.find(hash) != failed_graphics_pipelines.end())
+		{
+			return nullptr;
+		}
+
+		pending_graphics_pipelines.emplace(hash, promise->get_future().share());
+	}
+
+	++pending_pipeline_count;
+
+	// The job owns a copy of the state, as the caller keeps modifying its own
+	get_compile_pool().push(
+	    [this, hash, promise, cache = pipeline_cache, pipeline_state](size_t) mutable {
+		    is_compile_worker = true;
+
+		    try
+		    {
+			    build_pending_resource(device, recorder, graphics_pipeline_mutex, state.graphics_pipelines, get_counters(ResourceCacheType::GraphicsPipeline), pending_graphics_pipelines, hash, *promise, cache, pipeline_state);
+
+			    ++ready_pipeline_count;
+		    }
+		    catch (const std::exception &e)
+		    {
+			    LOGE("Background pipeline compilation failed: {}", e.what());
+
+			    std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+			    failed_graphics_pipelines.insert(hash);
+		    }
+
+		    --pending_pipeline_count;
+	    });
+
+	return nullptr;
+}
+
+ctpl::thread_pool &ResourceCache::get_compile_pool()
+{
+	std::call_once(compile_pool_flag, [this]() {
+		auto thread_count = std::thread::hardware_concurrency();
+		thread_count      = thread_count == 0 ? 1 : thread_count;
+		compile_pool      = std::make_unique<ctpl::thread_pool>(thread_count);
+	});
+
+	return *compile_pool;
+}
+
+uint32_t ResourceCache::get_pending_pipeline_count() const
+{
+	return pending_pipeline_count;
+}
+
+uint32_t ResourceCache::reset_ready_pipeline_count()
+{
+	return ready_pipeline_count.exchange(0);
 }
 
 ComputePipeline &ResourceCache::request_compute_pipeline(PipelineState &pipeline_state)
 {
-	return request_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, pipeline_cache, pipeline_state);
+	return request_pending_resource(device, recorder, compute_pipeline_mutex, state.compute_pipelines, get_counters(ResourceCacheType::ComputePipeline), pending_compute_pipelines, pipeline_cache, pipeline_state);
 }
 
 DescriptorSet &ResourceCache::request_descriptor_set(DescriptorSetLayout &descriptor_set_layout, const BindingMap<VkDescriptorBufferInfo> &buffer_infos, const BindingMap<VkDescriptorImageInfo> &image_infos)
 {
-	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, descriptor_set_layout);
-	return request_resource(device, recorder, descriptor_set_mutex, state.descriptor_sets, descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
+	auto &descriptor_pool = request_resource(device, recorder, descriptor_set_mutex, state.descriptor_pools, get_counters(ResourceCacheType::DescriptorPool), descriptor_set_layout);
+	return request_tracked_resource(
+	    device, recorder, descriptor_set_mutex, state.descriptor_sets, get_counters(ResourceCacheType::DescriptorSet), descriptor_set_lru, frame_index,
+	    [this](std::size_t key, DescriptorSet &descriptor_set) { image_view_index.add(key, descriptor_set); },
+	    descriptor_set_layout, descriptor_pool, buffer_infos, image_infos);
 }
 
 RenderPass &ResourceCache::request_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
-	return request_resource(device, recorder, render_pass_mutex, state.render_passes, attachments, load_store_infos, subpasses);
+	return request_resource(device, recorder, render_pass_mutex, state.render_passes, get_counters(ResourceCacheType::RenderPass), attachments, load_store_infos, subpasses);
 }
 
 Framebuffer &ResourceCache::request_framebuffer(const RenderTarget &render_target, const RenderPass &render_pass)
 {
-	return request_resource(device, recorder, framebuffer_mutex, state.framebuffers, render_target, render_pass);
+	return request_tracked_resource(
+	    device, recorder, framebuffer_mutex, state.framebuffers, get_counters(ResourceCacheType::Framebuffer), framebuffer_lru, frame_index,
+	    [](std::size_t, Framebuffer &) {},
+	    render_target, render_pass);
+}
+
+void ResourceCache::set_descriptor_set_limits(const ResourceCacheLimits &limits)
+{
+	std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+	descriptor_set_limits = limits;
+}
+
+void ResourceCache::set_framebuffer_limits(const ResourceCacheLimits &limits)
+{
+	std::lock_guard<std::mutex> guard(framebuffer_mutex);
+	framebuffer_limits = limits;
+}
+
+void ResourceCache::begin_frame(uint32_t frames_in_flight)
+{
+	auto current_frame = ++frame_index;
+
+	{
+		std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+
+		// Sets are returned to their pool, which is kept for future allocations
+		evicted_count += descriptor_set_lru.evict(state.descriptor_sets, descriptor_set_limits, current_frame, frames_in_flight,
+		                                          [this](std::size_t key, DescriptorSet &descriptor_set) {
+			                                          image_view_index.remove(key, descriptor_set);
+			                                          descriptor_set.get_descriptor_pool().free(descriptor_set.get_handle());
+		                                          });
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(framebuffer_mutex);
+
+		evicted_count += framebuffer_lru.evict(state.framebuffers, framebuffer_limits, current_frame, frames_in_flight,
+		                                       [](std::size_t, Framebuffer &) {});
+	}
+}
+
+void ResourceCache::add_evicted_count(uint32_t count)
+{
+	evicted_count += count;
+}
+
+uint32_t ResourceCache::reset_evicted_count()
+{
+	return evicted_count.exchange(0);
+}
+
+ResourceCacheTypeStats ResourceCache::get_stats(ResourceCacheType type)
+{
+	auto stats = get_counters(type).get_stats();
+
+	switch (type)
+	{
+		case ResourceCacheType::ShaderModule:
+		{
+			std::lock_guard<std::mutex> guard(shader_module_mutex);
+			stats.live_count = state.shader_modules.size();
+			break;
+		}
+		case ResourceCacheType::PipelineLayout:
+		{
+			std::lock_guard<std::mutex> guard(pipeline_layout_mutex);
+			stats.live_count = state.pipeline_layouts.size();
+			break;
+		}
+		case ResourceCacheType::DescriptorSetLayout:
+		{
+			std::lock_guard<std::mutex> guard(descriptor_set_layout_mutex);
+			stats.live_count = state.descriptor_set_layouts.size();
+			break;
+		}
+		case ResourceCacheType::DescriptorPool:
+		{
+			std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+			stats.live_count = state.descriptor_pools.size();
+			break;
+		}
+		case ResourceCacheType::RenderPass:
+		{
+			std::lock_guard<std::mutex> guard(render_pass_mutex);
+			stats.live_count = state.render_passes.size();
+			break;
+		}
+		case ResourceCacheType::GraphicsPipeline:
+		{
+			std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+			stats.live_count = state.graphics_pipelines.size();
+			break;
+		}
+		case ResourceCacheType::ComputePipeline:
+		{
+			std::lock_guard<std::mutex> guard(compute_pipeline_mutex);
+			stats.live_count = state.compute_pipelines.size();
+			break;
+		}
+		case ResourceCacheType::DescriptorSet:
+		{
+			std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+			stats.live_count = state.descriptor_sets.size();
+			break;
+		}
+		case ResourceCacheType::Framebuffer:
+		{
+			std::lock_guard<std::mutex> guard(framebuffer_mutex);
+			stats.live_count = state.framebuffers.size();
+			break;
+		}
+		default:
+			break;
+	}
+
+	return stats;
+}
+
+ResourceCacheCounters &ResourceCache::get_counters(ResourceCacheType type)
+{
+	return counters.at(static_cast<size_t>(type));
 }
 
 void ResourceCache::clear_pipelines()
 {
+	wait_pending_pipelines();
+
+	// Forget the destroyed pipelines, so that new ones created at the same address are not taken for replayed ones
+	for (auto &graphics_pipeline : state.graphics_pipelines)
+	{
+		recorder.take_replayed(&graphics_pipeline.second);
+	}
+
+	for (auto &compute_pipeline : state.compute_pipelines)
+	{
+		recorder.take_replayed(&compute_pipeline.second);
+	}
+
 	state.graphics_pipelines.clear();
+	failed_graphics_pipelines.clear();
 	state.compute_pipelines.clear();
 }
 
+std::vector<ShaderSource> ResourceCache::rebuild_shader_modules(const std::set<std::string> &changed_files)
+{
+	// Shader modules compiled from each affected file, directly or through an include
+	std::map<std::string, std::vector<ShaderModule *>> affected_modules;
+
+	{
+		std::lock_guard<std::mutex> guard(shader_module_mutex);
+
+		for (auto &shader_module_it : state.shader_modules)
+		{
+			auto &shader_module = shader_module_it.second;
+			auto &filename      = shader_module.get_source_filename();
+
+			if (filename.empty())
+			{
+				continue;
+			}
+
+			auto &includes = shader_module.get_source_includes();
+
+			if (changed_files.count(filename) > 0 ||
+			    std::any_of(includes.begin(), includes.end(), [&changed_files](const std::string &include) { return changed_files.count(include) > 0; }))
+			{
+				affected_modules[filename].push_back(&shader_module);
+			}
+		}
+	}
+
+	std::vector<ShaderSource> new_sources;
+
+	std::unordered_map<const ShaderModule *, ShaderModule *> replaced_modules;
+
+	for (auto &affected_it : affected_modules)
+	{
+		auto &old_modules = affected_it.second;
+
+		try
+		{
+			ShaderSource new_source{affected_it.first};
+
+			std::vector<ShaderModuleRequest> requests;
+			requests.reserve(old_modules.size());
+
+			for (auto old_module : old_modules)
+			{
+				requests.push_back({old_module->get_stage(), &new_source, old_module->get_shader_variant()});
+			}
+
+			auto new_modules = request_shader_modules(requests);
+
+			for (size_t i = 0; i < old_modules.size(); ++i)
+			{
+				if (new_modules[i] == old_modules[i])
+				{
+					continue;
+				}
+
+				// The descriptor set layouts depend on the binding method chosen for the old module
+				for (auto &resource : old_modules[i]->get_resources())
+				{
+					if (resource.mode != ShaderResourceMode::Static)
+					{
+						new_modules[i]->set_resource_mode(resource.name, resource.mode);
+					}
+				}
+
+				replaced_modules[old_modules[i]] = new_modules[i];
+			}
+
+			new_sources.push_back(std::move(new_source));
+		}
+		catch (const std::exception &e)
+		{
+			LOGE("Failed to reload shader \"{}\", keeping its previous version: {}", affected_it.first, e.what());
+		}
+	}
+
+	if (replaced_modules.empty())
+	{
+		return new_sources;
+	}
+
+	// Copies the state of a pipeline using the new shader modules, returns false if it does not use any replaced module
+	auto replace_pipeline_state = [this, &replaced_modules](const PipelineState &old_state, PipelineState &new_state) {
+		auto shader_modules = old_state.get_pipeline_layout().get_shader_modules();
+
+		bool replaced = false;
+
+		for (auto &shader_module : shader_modules)
+		{
+			auto replaced_it = replaced_modules.find(shader_module);
+
+			if (replaced_it != replaced_modules.end())
+			{
+				shader_module = replaced_it->second;
+				replaced      = true;
+			}
+		}
+
+		if (replaced)
+		{
+			new_state = old_state;
+			new_state.set_pipeline_layout(request_pipeline_layout(shader_modules));
+		}
+
+		return replaced;
+	};
+
+	std::vector<PipelineState> graphics_states;
+	std::vector<PipelineState> compute_states;
+
+	{
+		std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+
+		for (auto &pipeline_it : state.graphics_pipelines)
+		{
+			graphics_states.push_back(pipeline_it.second.get_state());
+		}
+	}
+
+	{
+		std::lock_guard<std::mutex> guard(compute_pipeline_mutex);
+
+		for (auto &pipeline_it : state.compute_pipelines)
+		{
+			compute_states.push_back(pipeline_it.second.get_state());
+		}
+	}
+
+	uint32_t pipeline_count = 0;
+
+	for (auto &old_state : graphics_states)
+	{
+		PipelineState new_state;
+
+		try
+		{
+			if (replace_pipeline_state(old_state, new_state))
+			{
+				request_graphics_pipeline_async(new_state);
+				++pipeline_count;
+			}
+		}
+		catch (const std::exception &e)
+		{
+			LOGE("Failed to rebuild graphics pipeline: {}", e.what());
+		}
+	}
+
+	for (auto &old_state : compute_states)
+	{
+		PipelineState new_state;
+
+		try
+		{
+			if (replace_pipeline_state(old_state, new_state))
+			{
+				request_compute_pipeline(new_state);
+				++pipeline_count;
+			}
+		}
+		catch (const std::exception &e)
+		{
+			LOGE("Failed to rebuild compute pipeline: {}", e.what());
+		}
+	}
+
+	wait_pending_pipelines();
+
+	LOGI("Rebuilt {} shader modules and {} pipelines", replaced_modules.size(), pipeline_count);
+
+	return new_sources;
+}
+
+void ResourceCache::wait_pending_pipelines()
+{
+	std::vector<std::shared_future<GraphicsPipeline *>> pending;
+
+	{
+		std::lock_guard<std::mutex> guard(graphics_pipeline_mutex);
+
+		for (auto &pending_it : pending_graphics_pipelines)
+		{
+			pending.push_back(pending_it.second);
+		}
+	}
+
+	// Errors have already been reported by the compile job
+	for (auto &future : pending)
+	{
+		future.wait();
+	}
+}
+
 void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &old_views, const std::vector<core::ImageView> &new_views)
 {
+	std::lock_guard<std::mutex> guard(descriptor_set_mutex);
+
 	// Find descriptor sets referring to the old image view
 	std::vector<VkWriteDescriptorSet> set_updates;
 	std::set<size_t>                  matches;
@@ -118,10 +1073,17 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 		auto &old_view = old_views[i];
 		auto &new_view = new_views[i];
 
-		for (auto &kd_pair : state.descriptor_sets)
+		// Only visit the descriptor sets referring to the old view, all references to it are replaced so it leaves the index
+		for (auto &key : image_view_index.take(old_view.get_handle()))
 		{
-			auto &key            = kd_pair.first;
-			auto &descriptor_set = kd_pair.second;
+			auto set_it = state.descriptor_sets.find(key);
+
+			if (set_it == state.descriptor_sets.end())
+			{
+				continue;
+			}
+
+			auto &descriptor_set = set_it->second;
 
 			auto &image_infos = descriptor_set.get_image_infos();
 
@@ -183,29 +1145,45 @@ void ResourceCache::update_descriptor_sets(const std::vector<core::ImageView> &o
 		auto descriptor_set = std::move(it->second);
 		state.descriptor_sets.erase(match);
 
-		// Generate new key
+		// The payload of the update template holds copies of the old image infos
+		descriptor_set.prepare_update_template_payload();
+
+		image_view_index.remove(match, descriptor_set);
+
+		// Generate new key, from the same arguments as request_descriptor_set
 		size_t new_key = 0U;
-		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
+		hash_param(new_key, descriptor_set.get_layout(), descriptor_set.get_descriptor_pool(), descriptor_set.get_buffer_infos(), descriptor_set.get_image_infos());
 
 		// Add (key, resource) to the cache
-		state.descriptor_sets.emplace(new_key, std::move(descriptor_set));
+		auto res_it = state.descriptor_sets.emplace(new_key, std::move(descriptor_set)).first;
+
+		image_view_index.add(new_key, res_it->second);
+
+		// Keep the last use of the descriptor set for eviction
+		descriptor_set_lru.rekey(match, new_key);
 	}
 }
 
 void ResourceCache::clear_framebuffers()
 {
 	state.framebuffers.clear();
+	framebuffer_lru.clear();
 }
 
 void ResourceCache::clear()
 {
+	wait_pending_pipelines();
+
 	state.shader_modules.clear();
 	state.pipeline_layouts.clear();
 	state.descriptor_sets.clear();
+	descriptor_set_lru.clear();
+	image_view_index.clear();
 	state.descriptor_set_layouts.clear();
 	state.render_passes.clear();
 	clear_pipelines();
 	clear_framebuffers();
+	recorder.clear_replayed();
 }
 
 const ResourceCacheState &ResourceCache::get_internal_state() const
@@ -17,8 +17,15 @@
 
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <future>
+#include <list>
+#include <mutex>
+#include <set>
 #include <string>
 #include <unordered_map>
+#include <unordered_set>
 #include <vector>
 
 #include "common/helpers.h"
@@ -30,6 +37,11 @@
 #include "resource_record.h"
 #include "resource_replay.h"
 
+namespace ctpl
+{
+class thread_pool;
+}
+
 namespace vkb
 {
 class Device;
@@ -64,6 +76,214 @@ struct ResourceCacheState
 	std::unordered_map<std::size_t, Framebuffer> framebuffers;
 };
 
+/// Types of objects stored in the resource cache
+enum class ResourceCacheType
+{
+	ShaderModule,
+	PipelineLayout,
+	DescriptorSetLayout,
+	DescriptorPool,
+	RenderPass,
+	GraphicsPipeline,
+	ComputePipeline,
+	DescriptorSet,
+	Framebuffer,
+	Count
+};
+
+/**
+ * @brief Statistics about the requests of one type of object made to the resource cache
+ */
+struct ResourceCacheTypeStats
+{
+	/// Number of buckets of the creation time histogram
+	static constexpr size_t CREATION_TIME_BUCKET_COUNT = 8;
+
+	/// Upper bounds of the histogram buckets in milliseconds, the last bucket holding all the slower creations
+	static const std::array<double, CREATION_TIME_BUCKET_COUNT - 1> creation_time_bucket_bounds;
+
+	/// Requests which found the object in the cache
+	uint64_t hits{0};
+
+	/// Requests which created the object
+	uint64_t misses{0};
+
+	/// Number of objects currently in the cache
+	size_t live_count{0};
+
+	/// Total time spent creating objects in milliseconds
+	double creation_time{0.0};
+
+	/// Longest time spent creating an object in milliseconds
+	double max_creation_time{0.0};
+
+	/// Number of creations per duration bucket
+	std::array<uint64_t, CREATION_TIME_BUCKET_COUNT> creation_time_histogram{};
+};
+
+/**
+ * @brief Counts the requests of one type of object, updated concurrently by the requesting threads
+ */
+class ResourceCacheCounters
+{
+  public:
+	void add_hit();
+
+	/**
+	 * @brief Counts a request which created an object
+	 * @param creation_time Time spent creating the object in milliseconds
+	 */
+	void add_miss(double creation_time);
+
+	/**
+	 * @return The counted statistics, without the live object count
+	 */
+	ResourceCacheTypeStats get_stats() const;
+
+  private:
+	std::atomic<uint64_t> hits{0};
+
+	mutable std::mutex creation_mutex;
+
+	/// Misses and creation times, guarded by creation_mutex
+	ResourceCacheTypeStats creation_stats;
+};
+
+/**
+ * @brief Limits on the number of objects of a type kept in the cache.
+ *        Objects beyond the limits are evicted, least recently used first,
+ *        once none of the frames in flight can use them anymore.
+ */
+struct ResourceCacheLimits
+{
+	/// Maximum number of cached objects, 0 for no limit
+	size_t max_count{0};
+
+	/// Number of frames after which an unused object is evicted, 0 to keep unused objects
+	uint32_t max_unused_frames{0};
+};
+
+/**
+ * @brief Keeps the keys of cached objects ordered from the least to the most recently used,
+ *        each stamped with the frame of its last use, so that eviction only visits the objects it evicts
+ */
+class ResourceCacheLru
+{
+  public:
+	/**
+	 * @brief Stamps an object with the frame in which it is used, making it the most recently used one
+	 */
+	void touch(std::size_t key, uint64_t frame_index);
+
+	/**
+	 * @brief Gives a new key to an object, keeping its last use
+	 */
+	void rekey(std::size_t old_key, std::size_t new_key);
+
+	void erase(std::size_t key);
+
+	void clear();
+
+	/**
+	 * @brief Evicts the least recently used objects which are not used by frames in flight,
+	 *        until the remaining ones fit in the limits
+	 * @param resources The cached objects, indexed by the keys given to touch
+	 * @param on_evict Called with the key and the object before it is destroyed
+	 * @return The number of evicted objects
+	 */
+	template <class T, class F>
+	uint32_t evict(std::unordered_map<std::size_t, T> &resources, const ResourceCacheLimits &limits, uint64_t frame_index, uint32_t frames_in_flight, F on_evict)
+	{
+		uint32_t evicted{0};
+
+		if (limits.max_count == 0 && limits.max_unused_frames == 0)
+		{
+			return evicted;
+		}
+
+		while (!entries.empty())
+		{
+			auto &oldest = entries.front();
+
+			// Objects used by a frame still in flight cannot be destroyed, and neither can the more recent ones
+			if (oldest.second + frames_in_flight > frame_index)
+			{
+				break;
+			}
+
+			bool expired     = limits.max_unused_frames != 0 && oldest.second + limits.max_unused_frames <= frame_index;
+			bool over_budget = limits.max_count != 0 && resources.size() > limits.max_count;
+
+			if (!expired && !over_budget)
+			{
+				break;
+			}
+
+			auto res_it = resources.find(oldest.first);
+
+			if (res_it != resources.end())
+			{
+				on_evict(res_it->first, res_it->second);
+				resources.erase(res_it);
+				++evicted;
+			}
+
+			positions.erase(oldest.first);
+			entries.pop_front();
+		}
+
+		return evicted;
+	}
+
+  private:
+	/// Keys and frames of last use, from the least to the most recently used
+	std::list<std::pair<std::size_t, uint64_t>> entries;
+
+	std::unordered_map<std::size_t, std::list<std::pair<std::size_t, uint64_t>>::iterator> positions;
+};
+
+/**
+ * @brief Indexes cached descriptor sets by the image views they refer to,
+ *        so that the sets affected by a change of image views are found without visiting all of them
+ */
+class DescriptorSetImageViewIndex
+{
+  public:
+	/**
+	 * @brief Adds a descriptor set under each image view of its image infos
+	 */
+	void add(std::size_t key, DescriptorSet &descriptor_set);
+
+	/**
+	 * @brief Removes a descriptor set from the entries of its image views
+	 */
+	void remove(std::size_t key, DescriptorSet &descriptor_set);
+
+	/**
+	 * @brief Removes an image view from the index
+	 * @return The keys of the descriptor sets which referred to it
+	 */
+	std::vector<std::size_t> take(VkImageView image_view);
+
+	void clear();
+
+  private:
+	std::unordered_map<VkImageView, std::unordered_set<std::size_t>> descriptor_sets;
+};
+
+/**
+ * @brief A shader module requested by ResourceCache::request_shader_modules
+ */
+struct ShaderModuleRequest
+{
+	VkShaderStageFlagBits stage;
+
+	/// Source of the shader, must stay alive until the request returns
+	const ShaderSource *glsl_source;
+
+	ShaderVariant shader_variant;
+};
+
 /**
  * @brief Cache all sorts of Vulkan objects specific to a Vulkan device.
  * Supports serialization and deserialization of cached resources.
@@ -74,11 +294,25 @@ struct ResourceCacheState
  * The resource cache is also linked with ResourceRecord and ResourceReplay. Replay can warm-up
  * the cache on app startup by creating all necessary objects.
  * The cache holds pointers to objects and has a mapping from such pointers to hashes.
- * It can only be destroyed in bulk, single elements cannot be removed.
+ * Most objects are only destroyed in bulk, only descriptor sets and framebuffers can be evicted individually.
+ *
+ * Shader modules and pipelines are built without holding their mutex: a pending entry is
+ * registered per hash, so different objects can be compiled in parallel by several threads,
+ * while threads requesting the same object wait for the first one to finish building it.
+ * Graphics pipelines can also be requested asynchronously, in which case missing pipelines
+ * are queued to a pool of compile worker threads and the request returns immediately.
+ *
+ * Hits, misses and creation times of every type of object are counted, see get_stats.
+ *
+ * Descriptor sets and framebuffers are stamped with the frame in which they were last requested.
+ * With ResourceCacheLimits set for them, begin_frame evicts the least recently used ones.
  */
 class ResourceCache
 {
   public:
+	/// Version of the warmup file format, to be increased whenever the recorded data changes
+	static constexpr uint32_t WARMUP_FILE_VERSION = 3;
+
 	ResourceCache(Device &device);
 
 	ResourceCache(const ResourceCache &) = delete;
@@ -89,14 +323,46 @@ class ResourceCache
 
 	ResourceCache &operator=(ResourceCache &&) = delete;
 
+	~ResourceCache();
+
+	/**
+	 * @brief Creates the resources recorded in a previous run.
+	 *        They are only recorded again once requested, so that unused resources are not saved anymore.
+	 */
 	void warmup(const std::vector<uint8_t> &data);
 
 	std::vector<uint8_t> serialize();
 
+	/**
+	 * @brief Serializes the recorded resources together with the data of the current pipeline cache
+	 *        The data starts with a header identifying the device, driver and format version
+	 * @return The contents of a warmup file
+	 */
+	std::vector<uint8_t> serialize_warmup_file();
+
+	/**
+	 * @brief Validates the contents of a warmup file and extracts its data
+	 * @param file_data The contents of a file written with serialize_warmup_file
+	 * @param pipeline_cache_data Output initial data for the pipeline cache
+	 * @param resource_data Output recorded resources to be passed to warmup
+	 * @return False if the data is corrupted or was created by another device, driver or format version
+	 */
+	bool deserialize_warmup_file(const std::vector<uint8_t> &file_data, std::vector<uint8_t> &pipeline_cache_data, std::vector<uint8_t> &resource_data) const;
+
 	void set_pipeline_cache(VkPipelineCache pipeline_cache);
 
 	ShaderModule &request_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const ShaderVariant &shader_variant = {});
 
+	/**
+	 * @brief Requests several shader modules, compiling the missing ones in parallel on the worker threads
+	 *        Called from a worker thread, for example while building a pipeline in the background,
+	 *        the modules are compiled one after the other on that thread instead of waiting for the other workers
+	 * @param requests The stage, source and variant of each shader module
+	 * @return The shader modules in the order of the requests
+	 * @throws The first error raised while compiling a shader module, once all of them are done
+	 */
+	std::vector<ShaderModule *> request_shader_modules(const std::vector<ShaderModuleRequest> &requests);
+
 	PipelineLayout &request_pipeline_layout(const std::vector<ShaderModule *> &shader_modules);
 
 	DescriptorSetLayout &request_descriptor_set_layout(const uint32_t                     set_index,
@@ -105,6 +371,24 @@ class ResourceCache
 
 	GraphicsPipeline &request_graphics_pipeline(PipelineState &pipeline_state);
 
+	/**
+	 * @brief Requests a graphics pipeline without blocking on its creation
+	 * @param pipeline_state The state of the pipeline, copied if it needs to be built
+	 * @return The pipeline if it is ready, otherwise nullptr while it is built by a background thread,
+	 *         or if building it failed, in which case it is not queued again until clear_pipelines
+	 */
+	GraphicsPipeline *request_graphics_pipeline_async(PipelineState &pipeline_state);
+
+	/**
+	 * @return The number of pipelines queued or being built in the background
+	 */
+	uint32_t get_pending_pipeline_count() const;
+
+	/**
+	 * @return The number of background pipelines which became ready since the last call
+	 */
+	uint32_t reset_ready_pipeline_count();
+
 	ComputePipeline &request_compute_pipeline(PipelineState &pipeline_state);
 
 	DescriptorSet &request_descriptor_set(DescriptorSetLayout &                     descriptor_set_layout,
@@ -118,8 +402,55 @@ class ResourceCache
 	Framebuffer &request_framebuffer(const RenderTarget &render_target,
 	                                 const RenderPass &  render_pass);
 
+	/**
+	 * @brief Sets the limits of the descriptor sets requested from the cache, applied from the next call to begin_frame
+	 *        Command buffers request their descriptor sets from their RenderFrame, see RenderContext::set_descriptor_set_limits
+	 */
+	void set_descriptor_set_limits(const ResourceCacheLimits &limits);
+
+	/**
+	 * @brief Sets the limits of the cached framebuffers, applied from the next call to begin_frame
+	 */
+	void set_framebuffer_limits(const ResourceCacheLimits &limits);
+
+	/**
+	 * @brief Starts a new frame and evicts the objects beyond the cache limits
+	 *        Must be called once the GPU has finished the oldest frame in flight
+	 * @param frames_in_flight Number of frames which may still use cached objects, including the new one
+	 */
+	void begin_frame(uint32_t frames_in_flight);
+
+	/**
+	 * @brief Counts objects evicted from another cache, such as the descriptor sets of a RenderFrame,
+	 *        so that they are reported with the evictions of this cache
+	 */
+	void add_evicted_count(uint32_t count);
+
+	/**
+	 * @return The number of objects evicted since the last call
+	 */
+	uint32_t reset_evicted_count();
+
+	/**
+	 * @param type The type of object
+	 * @return The request statistics and the number of cached objects of the given type
+	 */
+	ResourceCacheTypeStats get_stats(ResourceCacheType type);
+
 	void clear_pipelines();
 
+	/**
+	 * @brief Recompiles the shader modules affected by changed shader files, and rebuilds the pipelines using them
+	 *        The new objects are added next to the old ones, which may still be in use until the sources are swapped
+	 * @param changed_files Shader files which changed, relative to the shader directory
+	 * @return The new sources of the shader files which were rebuilt, to be applied with ShaderSource::reload
+	 *         Files failing to compile are logged and left out, so that their previous version stays in use
+	 */
+	std::vector<ShaderSource> rebuild_shader_modules(const std::set<std::string> &changed_files);
+
+	/// @brief Blocks until all pipelines queued in the background have been built
+	void wait_pending_pipelines();
+
 	/// @brief Update those descriptor sets referring to old views
 	/// @param old_views Old image views referred by descriptor sets
 	/// @param new_views New image views to be referred
@@ -132,6 +463,11 @@ class ResourceCache
 	const ResourceCacheState &get_internal_state() const;
 
   private:
+	ResourceCacheCounters &get_counters(ResourceCacheType type);
+
+	/// @brief Gets the compile worker threads, creating them on first use
+	ctpl::thread_pool &get_compile_pool();
+
 	Device &device;
 
 	ResourceRecord recorder;
@@ -157,5 +493,46 @@ class ResourceCache
 	std::mutex compute_pipeline_mutex;
 
 	std::mutex framebuffer_mutex;
+
+	/// Shader modules which are currently being compiled, guarded by shader_module_mutex
+	std::unordered_map<std::size_t, std::shared_future<ShaderModule *>> pending_shader_modules;
+
+	/// Graphics pipelines which are currently being built, guarded by graphics_pipeline_mutex
+	std::unordered_map<std::size_t, std::shared_future<GraphicsPipeline *>> pending_graphics_pipelines;
+
+	/// Graphics pipelines which failed to build in the background, guarded by graphics_pipeline_mutex
+	std::unordered_set<std::size_t> failed_graphics_pipelines;
+
+	/// Compute pipelines which are currently being built, guarded by compute_pipeline_mutex
+	std::unordered_map<std::size_t, std::shared_future<ComputePipeline *>> pending_compute_pipelines;
+
+	/// Worker threads for asynchronous pipeline and bulk shader compilation, created on first use
+	std::unique_ptr<ctpl::thread_pool> compile_pool;
+
+	std::once_flag compile_pool_flag;
+
+	std::atomic<uint32_t> pending_pipeline_count{0};
+
+	std::atomic<uint32_t> ready_pipeline_count{0};
+
+	/// Index of the current frame, increased by begin_frame
+	std::atomic<uint64_t> frame_index{0};
+
+	ResourceCacheLimits descriptor_set_limits;
+
+	ResourceCacheLimits framebuffer_limits;
+
+	/// Last use of each descriptor set, guarded by descriptor_set_mutex
+	ResourceCacheLru descriptor_set_lru;
+
+	/// Keys of the cached descriptor sets referring to each image view, guarded by descriptor_set_mutex
+	DescriptorSetImageViewIndex image_view_index;
+
+	/// Last use of each framebuffer, guarded by framebuffer_mutex
+	ResourceCacheLru framebuffer_lru;
+
+	std::atomic<uint32_t> evicted_count{0};
+
+	std::array<ResourceCacheCounters, static_cast<size_t>(ResourceCacheType::Count)> counters;
 };
 }        // namespace vkb
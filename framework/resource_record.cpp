@@ -17,6 +17,7 @@
 
 #include "resource_record.h"
 
+#include "core/descriptor_set_layout.h"
 #include "core/pipeline.h"
 #include "core/pipeline_layout.h"
 #include "core/render_pass.h"
@@ -37,6 +38,30 @@ inline void write_subpass_info(std::ostringstream &os, const std::vector<Subpass
 	}
 }
 
+inline void write_shader_resources(std::ostringstream &os, const std::vector<ShaderResource> &value)
+{
+	write(os, value.size());
+	for (const ShaderResource &item : value)
+	{
+		write(os,
+		      item.stages,
+		      item.type,
+		      item.mode,
+		      item.set,
+		      item.binding,
+		      item.location,
+		      item.input_attachment_index,
+		      item.vec_size,
+		      item.columns,
+		      item.array_size,
+		      item.offset,
+		      item.size,
+		      item.constant_id,
+		      item.qualifiers,
+		      item.name);
+	}
+}
+
 inline void write_processes(std::ostringstream &os, const std::vector<std::string> &value)
 {
 	write(os, value.size());
@@ -49,11 +74,15 @@ inline void write_processes(std::ostringstream &os, const std::vector<std::strin
 
 void ResourceRecord::set_data(const std::vector<uint8_t> &data)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	stream.str(std::string{data.begin(), data.end()});
 }
 
 std::vector<uint8_t> ResourceRecord::get_data()
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	std::string str = stream.str();
 
 	return std::vector<uint8_t>{str.begin(), str.end()};
@@ -66,9 +95,11 @@ const std::ostringstream &ResourceRecord::get_stream()
 
 size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const ShaderSource &glsl_source, const std::string &entry_point, const ShaderVariant &shader_variant)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_indices.push_back(shader_module_indices.size());
 
-	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_source(), entry_point, shader_variant.get_preamble());
+	write(stream, ResourceType::ShaderModule, stage, glsl_source.get_source(), entry_point);
 
 	write_processes(stream, shader_variant.get_processes());
 
@@ -77,6 +108,8 @@ size_t ResourceRecord::register_shader_module(VkShaderStageFlagBits stage, const
 
 size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *> &shader_modules)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_indices.push_back(pipeline_layout_indices.size());
 
 	std::vector<size_t> shader_indices(shader_modules.size());
@@ -92,6 +125,8 @@ size_t ResourceRecord::register_pipeline_layout(const std::vector<ShaderModule *
 
 size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attachments, const std::vector<LoadStoreInfo> &load_store_infos, const std::vector<SubpassInfo> &subpasses)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_indices.push_back(render_pass_indices.size());
 
 	write(stream,
@@ -106,6 +141,8 @@ size_t ResourceRecord::register_render_pass(const std::vector<Attachment> &attac
 
 size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_indices.push_back(graphics_pipeline_indices.size());
 
 	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
@@ -145,24 +182,122 @@ size_t ResourceRecord::register_graphics_pipeline(VkPipelineCache /*pipeline_cac
 	return graphics_pipeline_indices.back();
 }
 
+size_t ResourceRecord::register_compute_pipeline(VkPipelineCache /*pipeline_cache*/, PipelineState &pipeline_state)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	compute_pipeline_indices.push_back(compute_pipeline_indices.size());
+
+	auto &pipeline_layout = pipeline_state.get_pipeline_layout();
+
+	write(stream,
+	      ResourceType::ComputePipeline,
+	      pipeline_layout_to_index.at(&pipeline_layout));
+
+	auto &specialization_constant_state = pipeline_state.get_specialization_constant_state().get_specialization_constant_state();
+
+	write(stream,
+	      specialization_constant_state);
+
+	return compute_pipeline_indices.back();
+}
+
+size_t ResourceRecord::register_descriptor_set_layout(const uint32_t set_index, const std::vector<ShaderModule *> &shader_modules, const std::vector<ShaderResource> &set_resources)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	descriptor_set_layout_indices.push_back(descriptor_set_layout_indices.size());
+
+	std::vector<size_t> shader_indices(shader_modules.size());
+	std::transform(shader_modules.begin(), shader_modules.end(), shader_indices.begin(),
+	               [this](ShaderModule *shader_module) { return shader_module_to_index.at(shader_module); });
+
+	write(stream,
+	      ResourceType::DescriptorSetLayout,
+	      set_index,
+	      shader_indices);
+
+	write_shader_resources(stream, set_resources);
+
+	return descriptor_set_layout_indices.back();
+}
+
 void ResourceRecord::set_shader_module(size_t index, const ShaderModule &shader_module)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	shader_module_to_index[&shader_module] = index;
 }
 
 void ResourceRecord::set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	pipeline_layout_to_index[&pipeline_layout] = index;
 }
 
 void ResourceRecord::set_render_pass(size_t index, const RenderPass &render_pass)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	render_pass_to_index[&render_pass] = index;
 }
 
 void ResourceRecord::set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline)
 {
+	std::lock_guard<std::mutex> guard(mutex);
+
 	graphics_pipeline_to_index[&graphics_pipeline] = index;
 }
 
+void ResourceRecord::set_compute_pipeline(size_t index, const ComputePipeline &compute_pipeline)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	compute_pipeline_to_index[&compute_pipeline] = index;
+}
+
+void ResourceRecord::set_descriptor_set_layout(size_t index, const DescriptorSetLayout &descriptor_set_layout)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	descriptor_set_layout_to_index[&descriptor_set_layout] = index;
+}
+
+void ResourceRecord::set_replaying(bool new_replaying)
+{
+	replaying = new_replaying;
+}
+
+bool ResourceRecord::is_replaying() const
+{
+	return replaying;
+}
+
+void ResourceRecord::add_replayed(const void *resource)
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	replayed_resources.insert(resource);
+}
+
+bool ResourceRecord::take_replayed(const void *resource)
+{
+	if (replaying)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> guard(mutex);
+
+	return replayed_resources.erase(resource) > 0;
+}
+
+void ResourceRecord::clear_replayed()
+{
+	std::lock_guard<std::mutex> guard(mutex);
+
+	replayed_resources.clear();
+}
+
 }        // namespace vkb
@@ -17,12 +17,17 @@
 
 #pragma once
 
+#include <atomic>
+#include <mutex>
+#include <unordered_set>
 #include <vector>
 
 #include "rendering/pipeline_state.h"
 
 namespace vkb
 {
+class ComputePipeline;
+class DescriptorSetLayout;
 class GraphicsPipeline;
 class PipelineLayout;
 class RenderPass;
@@ -33,11 +38,14 @@ enum class ResourceType
 	ShaderModule,
 	PipelineLayout,
 	RenderPass,
-	GraphicsPipeline
+	GraphicsPipeline,
+	ComputePipeline,
+	DescriptorSetLayout
 };
 
 /**
  * @brief Writes Vulkan objects in a memory stream.
+ *        Resources can be registered concurrently by several threads, for example during a parallel replay.
  */
 class ResourceRecord
 {
@@ -62,6 +70,13 @@ class ResourceRecord
 	size_t register_graphics_pipeline(VkPipelineCache pipeline_cache,
 	                                  PipelineState & pipeline_state);
 
+	size_t register_compute_pipeline(VkPipelineCache pipeline_cache,
+	                                 PipelineState & pipeline_state);
+
+	size_t register_descriptor_set_layout(const uint32_t                     set_index,
+	                                      const std::vector<ShaderModule *> &shader_modules,
+	                                      const std::vector<ShaderResource> &set_resources);
+
 	void set_shader_module(size_t index, const ShaderModule &shader_module);
 
 	void set_pipeline_layout(size_t index, const PipelineLayout &pipeline_layout);
@@ -70,7 +85,31 @@ class ResourceRecord
 
 	void set_graphics_pipeline(size_t index, const GraphicsPipeline &graphics_pipeline);
 
+	void set_compute_pipeline(size_t index, const ComputePipeline &compute_pipeline);
+
+	void set_descriptor_set_layout(size_t index, const DescriptorSetLayout &descriptor_set_layout);
+
+	/**
+	 * @brief While replaying, the created resources are not recorded but remembered as replayed,
+	 *        so that only the resources requested again by the application are saved
+	 */
+	void set_replaying(bool replaying);
+
+	bool is_replaying() const;
+
+	void add_replayed(const void *resource);
+
+	/**
+	 * @return True if the resource was created by a replay and not recorded since, forgetting it
+	 */
+	bool take_replayed(const void *resource);
+
+	void clear_replayed();
+
   private:
+	/// Guards the stream and the index maps
+	std::mutex mutex;
+
 	std::ostringstream stream;
 
 	std::vector<size_t> shader_module_indices;
@@ -81,6 +120,10 @@ class ResourceRecord
 
 	std::vector<size_t> graphics_pipeline_indices;
 
+	std::vector<size_t> compute_pipeline_indices;
+
+	std::vector<size_t> descriptor_set_layout_indices;
+
 	std::unordered_map<const ShaderModule *, size_t> shader_module_to_index;
 
 	std::unordered_map<const PipelineLayout *, size_t> pipeline_layout_to_index;
@@ -88,5 +131,14 @@ class ResourceRecord
 	std::unordered_map<const RenderPass *, size_t> render_pass_to_index;
 
 	std::unordered_map<const GraphicsPipeline *, size_t> graphics_pipeline_to_index;
+
+	std::unordered_map<const ComputePipeline *, size_t> compute_pipeline_to_index;
+
+	std::unordered_map<const DescriptorSetLayout *, size_t> descriptor_set_layout_to_index;
+
+	std::atomic<bool> replaying{false};
+
+	/// Resources created by a replay which have not been recorded yet, guarded by the mutex
+	std::unordered_set<const void *> replayed_resources;
 };
 }        // namespace vkb
@@ -17,6 +17,12 @@
 
 #include "resource_replay.h"
 
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+
+#include <ctpl_stl.h>
+
 #include "common/logging.h"
 #include "common/vk_common.h"
 #include "rendering/pipeline_state.h"
@@ -38,6 +44,32 @@ inline void read_subpass_info(std::istringstream &is, std::vector<SubpassInfo> &
 	}
 }
 
+inline void read_shader_resources(std::istringstream &is, std::vector<ShaderResource> &value)
+{
+	std::size_t size;
+	read(is, size);
+	value.resize(size);
+	for (ShaderResource &item : value)
+	{
+		read(is,
+		     item.stages,
+		     item.type,
+		     item.mode,
+		     item.set,
+		     item.binding,
+		     item.location,
+		     item.input_attachment_index,
+		     item.vec_size,
+		     item.columns,
+		     item.array_size,
+		     item.offset,
+		     item.size,
+		     item.constant_id,
+		     item.qualifiers,
+		     item.name);
+	}
+}
+
 inline void read_processes(std::istringstream &is, std::vector<std::string> &value)
 {
 	std::size_t size;
@@ -52,15 +84,31 @@ inline void read_processes(std::istringstream &is, std::vector<std::string> &val
 
 ResourceReplay::ResourceReplay()
 {
-	stream_resources[ResourceType::ShaderModule]     = std::bind(&ResourceReplay::create_shader_module, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::PipelineLayout]   = std::bind(&ResourceReplay::create_pipeline_layout, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::RenderPass]       = std::bind(&ResourceReplay::create_render_pass, this, std::placeholders::_1, std::placeholders::_2);
-	stream_resources[ResourceType::GraphicsPipeline] = std::bind(&ResourceReplay::create_graphics_pipeline, this, std::placeholders::_1, std::placeholders::_2);
+	stream_resources[ResourceType::ShaderModule]        = std::bind(&ResourceReplay::read_shader_module, this, std::placeholders::_1);
+	stream_resources[ResourceType::PipelineLayout]      = std::bind(&ResourceReplay::read_pipeline_layout, this, std::placeholders::_1);
+	stream_resources[ResourceType::RenderPass]          = std::bind(&ResourceReplay::read_render_pass, this, std::placeholders::_1);
+	stream_resources[ResourceType::GraphicsPipeline]    = std::bind(&ResourceReplay::read_graphics_pipeline, this, std::placeholders::_1);
+	stream_resources[ResourceType::ComputePipeline]     = std::bind(&ResourceReplay::read_compute_pipeline, this, std::placeholders::_1);
+	stream_resources[ResourceType::DescriptorSetLayout] = std::bind(&ResourceReplay::read_descriptor_set_layout, this, std::placeholders::_1);
 }
 
-void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorder)
+void ResourceReplay::play(ResourceCache &resource_cache, const std::vector<uint8_t> &data)
 {
-	std::istringstream stream{recorder.get_stream().str()};
+	std::istringstream stream{std::string{data.begin(), data.end()}};
+
+	tasks.clear();
+	shader_module_tasks.clear();
+	pipeline_layout_tasks.clear();
+	render_pass_tasks.clear();
+	graphics_pipeline_tasks.clear();
+	compute_pipeline_tasks.clear();
+	descriptor_set_layout_tasks.clear();
+	shader_modules.clear();
+	pipeline_layouts.clear();
+	render_passes.clear();
+	graphics_pipelines.clear();
+	compute_pipelines.clear();
+	descriptor_set_layouts.clear();
 
 	while (true)
 	{
@@ -80,57 +128,161 @@ void ResourceReplay::play(ResourceCache &resource_cache, ResourceRecord &recorde
 		if (cmd_it != stream_resources.end())
 		{
 			// Run command function
-			cmd_it->second(resource_cache, stream);
+			cmd_it->second(stream);
 		}
 		else
 		{
 			LOGE("Replay command not supported.");
 		}
 	}
+
+	run_tasks(resource_cache);
+}
+
+size_t ResourceReplay::add_task(CreateFunc &&create, const std::vector<size_t> &dependencies)
+{
+	size_t task_index = tasks.size();
+
+	ReplayTask task{};
+	task.create           = std::move(create);
+	task.dependency_count = dependencies.size();
+
+	for (auto dependency : dependencies)
+	{
+		tasks.at(dependency).dependents.push_back(task_index);
+	}
+
+	tasks.push_back(std::move(task));
+
+	return task_index;
+}
+
+void ResourceReplay::run_tasks(ResourceCache &resource_cache)
+{
+	if (tasks.empty())
+	{
+		return;
+	}
+
+	// Number of dependencies of every task which are not created yet
+	std::vector<std::atomic<size_t>> remaining_dependencies(tasks.size());
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		remaining_dependencies[i] = tasks[i].dependency_count;
+	}
+
+	std::mutex              done_mutex;
+	std::condition_variable done_condition;
+	size_t                  done_count{0};
+
+	auto thread_count = std::thread::hardware_concurrency();
+	thread_count      = thread_count == 0 ? 1 : thread_count;
+	ctpl::thread_pool thread_pool(thread_count);
+
+	std::function<void(size_t)> push_task = [&](size_t task_index) {
+		thread_pool.push([&, task_index](size_t) {
+			auto &task = tasks[task_index];
+
+			try
+			{
+				task.create(resource_cache);
+			}
+			catch (const std::exception &e)
+			{
+				LOGE("Failed to replay resource: {}", e.what());
+			}
+
+			// Dependents of a failed task still run, and report the missing resource themselves
+			for (auto dependent : task.dependents)
+			{
+				if (--remaining_dependencies[dependent] == 0)
+				{
+					push_task(dependent);
+				}
+			}
+
+			std::lock_guard<std::mutex> guard(done_mutex);
+			++done_count;
+			done_condition.notify_one();
+		});
+	};
+
+	for (size_t i = 0; i < tasks.size(); ++i)
+	{
+		if (tasks[i].dependency_count == 0)
+		{
+			push_task(i);
+		}
+	}
+
+	{
+		std::unique_lock<std::mutex> lock(done_mutex);
+		done_condition.wait(lock, [&]() { return done_count == tasks.size(); });
+	}
+
+	// Join the workers before the state they refer to goes out of scope
+	thread_pool.stop(true);
 }
 
-void ResourceReplay::create_shader_module(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::read_shader_module(std::istringstream &stream)
 {
 	VkShaderStageFlagBits    stage{};
 	std::string              glsl_source;
 	std::string              entry_point;
-	std::string              preamble;
 	std::vector<std::string> processes;
 
 	read(stream,
 	     stage,
 	     glsl_source,
-	     entry_point,
-	     preamble);
+	     entry_point);
 
 	read_processes(stream, processes);
 
 	ShaderSource shader_source{};
 	shader_source.set_source(std::move(glsl_source));
-	ShaderVariant shader_variant(std::move(preamble), std::move(processes));
+	ShaderVariant shader_variant(processes);
 
-	auto &shader_module = resource_cache.request_shader_module(stage, shader_source, shader_variant);
+	size_t index = shader_modules.size();
+	shader_modules.push_back(nullptr);
 
-	shader_modules.push_back(&shader_module);
+	shader_module_tasks.push_back(add_task(
+	    [this, index, stage, shader_source, shader_variant](ResourceCache &resource_cache) {
+		    shader_modules[index] = &resource_cache.request_shader_module(stage, shader_source, shader_variant);
+	    },
+	    {}));
 }
 
-void ResourceReplay::create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::read_pipeline_layout(std::istringstream &stream)
 {
 	std::vector<size_t> shader_indices;
 
 	read(stream,
 	     shader_indices);
 
-	std::vector<ShaderModule *> shader_stages(shader_indices.size());
-	std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
-	               [&](size_t shader_index) { return shader_modules.at(shader_index); });
+	std::vector<size_t> dependencies(shader_indices.size());
+	std::transform(shader_indices.begin(), shader_indices.end(), dependencies.begin(),
+	               [&](size_t shader_index) { return shader_module_tasks.at(shader_index); });
+
+	size_t index = pipeline_layouts.size();
+	pipeline_layouts.push_back(nullptr);
 
-	auto &pipeline_layout = resource_cache.request_pipeline_layout(shader_stages);
+	pipeline_layout_tasks.push_back(add_task(
+	    [this, index, shader_indices](ResourceCache &resource_cache) {
+		    std::vector<ShaderModule *> shader_stages(shader_indices.size());
+		    std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
+		                   [&](size_t shader_index) { return shader_modules[shader_index]; });
 
-	pipeline_layouts.push_back(&pipeline_layout);
+		    if (std::find(shader_stages.begin(), shader_stages.end(), nullptr) != shader_stages.end())
+		    {
+			    throw std::runtime_error("Pipeline layout refers to a shader module which failed to replay");
+		    }
+
+		    pipeline_layouts[index] = &resource_cache.request_pipeline_layout(shader_stages);
+	    },
+	    dependencies));
 }
 
-void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::read_render_pass(std::istringstream &stream)
 {
 	std::vector<Attachment>    attachments;
 	std::vector<LoadStoreInfo> load_store_infos;
@@ -142,12 +294,17 @@ void ResourceReplay::create_render_pass(ResourceCache &resource_cache, std::istr
 
 	read_subpass_info(stream, subpasses);
 
-	auto &render_pass = resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	size_t index = render_passes.size();
+	render_passes.push_back(nullptr);
 
-	render_passes.push_back(&render_pass);
+	render_pass_tasks.push_back(add_task(
+	    [this, index, attachments, load_store_infos, subpasses](ResourceCache &resource_cache) {
+		    render_passes[index] = &resource_cache.request_render_pass(attachments, load_store_infos, subpasses);
+	    },
+	    {}));
 }
 
-void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream)
+void ResourceReplay::read_graphics_pipeline(std::istringstream &stream)
 {
 	size_t   pipeline_layout_index{};
 	size_t   render_pass_index{};
@@ -188,9 +345,8 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	     color_blend_state.logic_op_enable,
 	     color_blend_state.attachments);
 
+	// Pipeline layout and render pass are set once they have been created
 	PipelineState pipeline_state{};
-	pipeline_state.set_pipeline_layout(*pipeline_layouts.at(pipeline_layout_index));
-	pipeline_state.set_render_pass(*render_passes.at(render_pass_index));
 
 	for (auto &item : specialization_constant_state)
 	{
@@ -206,8 +362,97 @@ void ResourceReplay::create_graphics_pipeline(ResourceCache &resource_cache, std
 	pipeline_state.set_depth_stencil_state(depth_stencil_state);
 	pipeline_state.set_color_blend_state(color_blend_state);
 
-	auto &graphics_pipeline = resource_cache.request_graphics_pipeline(pipeline_state);
+	size_t index = graphics_pipelines.size();
+	graphics_pipelines.push_back(nullptr);
+
+	graphics_pipeline_tasks.push_back(add_task(
+	    [this, index, pipeline_layout_index, render_pass_index, pipeline_state](ResourceCache &resource_cache) mutable {
+		    auto pipeline_layout = pipeline_layouts[pipeline_layout_index];
+		    auto render_pass     = render_passes[render_pass_index];
+
+		    if (!pipeline_layout || !render_pass)
+		    {
+			    throw std::runtime_error("Graphics pipeline refers to a resource which failed to replay");
+		    }
+
+		    pipeline_state.set_pipeline_layout(*pipeline_layout);
+		    pipeline_state.set_render_pass(*render_pass);
+
+		    graphics_pipelines[index] = &resource_cache.request_graphics_pipeline(pipeline_state);
+	    },
+	    {pipeline_layout_tasks.at(pipeline_layout_index), render_pass_tasks.at(render_pass_index)}));
+}
+
+void ResourceReplay::read_compute_pipeline(std::istringstream &stream)
+{
+	size_t pipeline_layout_index{};
+
+	read(stream,
+	     pipeline_layout_index);
+
+	std::map<uint32_t, std::vector<uint8_t>> specialization_constant_state{};
+	read(stream,
+	     specialization_constant_state);
+
+	// Pipeline layout is set once it has been created
+	PipelineState pipeline_state{};
+
+	for (auto &item : specialization_constant_state)
+	{
+		pipeline_state.set_specialization_constant(item.first, item.second);
+	}
+
+	size_t index = compute_pipelines.size();
+	compute_pipelines.push_back(nullptr);
+
+	compute_pipeline_tasks.push_back(add_task(
+	    [this, index, pipeline_layout_index, pipeline_state](ResourceCache &resource_cache) mutable {
+		    auto pipeline_layout = pipeline_layouts[pipeline_layout_index];
+
+		    if (!pipeline_layout)
+		    {
+			    throw std::runtime_error("Compute pipeline refers to a pipeline layout which failed to replay");
+		    }
+
+		    pipeline_state.set_pipeline_layout(*pipeline_layout);
+
+		    compute_pipelines[index] = &resource_cache.request_compute_pipeline(pipeline_state);
+	    },
+	    {pipeline_layout_tasks.at(pipeline_layout_index)}));
+}
+
+void ResourceReplay::read_descriptor_set_layout(std::istringstream &stream)
+{
+	uint32_t                    set_index{};
+	std::vector<size_t>         shader_indices;
+	std::vector<ShaderResource> set_resources;
+
+	read(stream,
+	     set_index,
+	     shader_indices);
+
+	read_shader_resources(stream, set_resources);
+
+	std::vector<size_t> dependencies(shader_indices.size());
+	std::transform(shader_indices.begin(), shader_indices.end(), dependencies.begin(),
+	               [&](size_t shader_index) { return shader_module_tasks.at(shader_index); });
+
+	size_t index = descriptor_set_layouts.size();
+	descriptor_set_layouts.push_back(nullptr);
+
+	descriptor_set_layout_tasks.push_back(add_task(
+	    [this, index, set_index, shader_indices, set_resources](ResourceCache &resource_cache) {
+		    std::vector<ShaderModule *> shader_stages(shader_indices.size());
+		    std::transform(shader_indices.begin(), shader_indices.end(), shader_stages.begin(),
+		                   [&](size_t shader_index) { return shader_modules[shader_index]; });
+
+		    if (std::find(shader_stages.begin(), shader_stages.end(), nullptr) != shader_stages.end())
+		    {
+			    throw std::runtime_error("Descriptor set layout refers to a shader module which failed to replay");
+		    }
 
-	graphics_pipelines.push_back(&graphics_pipeline);
+		    descriptor_set_layouts[index] = &resource_cache.request_descriptor_set_layout(set_index, shader_stages, set_resources);
+	    },
+	    dependencies));
 }
 }        // namespace vkb
@@ -25,28 +25,80 @@ class ResourceCache;
 
 /**
  * @brief Reads Vulkan objects from a memory stream and creates them in the resource cache.
+ *        The recorded indices form a dependency graph between resources: each resource is
+ *        created on a thread pool as soon as all the resources it refers to have been created,
+ *        so independent shader modules and pipelines are built concurrently.
  */
 class ResourceReplay
 {
   public:
 	ResourceReplay();
 
-	void play(ResourceCache &resource_cache, ResourceRecord &recorder);
+	/**
+	 * @brief Creates the resources recorded in a memory stream
+	 * @param resource_cache The cache creating the resources, which records them again as they are created
+	 * @param data The data of a ResourceRecord
+	 */
+	void play(ResourceCache &resource_cache, const std::vector<uint8_t> &data);
 
   protected:
-	void create_shader_module(ResourceCache &resource_cache, std::istringstream &stream);
+	void read_shader_module(std::istringstream &stream);
 
-	void create_pipeline_layout(ResourceCache &resource_cache, std::istringstream &stream);
+	void read_pipeline_layout(std::istringstream &stream);
 
-	void create_render_pass(ResourceCache &resource_cache, std::istringstream &stream);
+	void read_render_pass(std::istringstream &stream);
 
-	void create_graphics_pipeline(ResourceCache &resource_cache, std::istringstream &stream);
+	void read_graphics_pipeline(std::istringstream &stream);
+
+	void read_compute_pipeline(std::istringstream &stream);
+
+	void read_descriptor_set_layout(std::istringstream &stream);
 
   private:
-	using ResourceFunc = std::function<void(ResourceCache &, std::istringstream &)>;
+	using CreateFunc = std::function<void(ResourceCache &)>;
+
+	/// A resource read from the stream, waiting to be created
+	struct ReplayTask
+	{
+		CreateFunc create;
+
+		/// Indices of the tasks which refer to this resource
+		std::vector<size_t> dependents;
+
+		size_t dependency_count{0};
+	};
+
+	/**
+	 * @brief Adds a task to the dependency graph
+	 * @param create Function creating the resource
+	 * @param dependencies Indices of the tasks which need to complete before this one
+	 * @return The index of the new task
+	 */
+	size_t add_task(CreateFunc &&create, const std::vector<size_t> &dependencies);
+
+	/// @brief Runs all the tasks on a thread pool, following the dependency graph
+	void run_tasks(ResourceCache &resource_cache);
+
+	using ResourceFunc = std::function<void(std::istringstream &)>;
 
 	std::unordered_map<ResourceType, ResourceFunc> stream_resources;
 
+	std::vector<ReplayTask> tasks;
+
+	/// Task index of every recorded resource, indexed by the recorded resource index
+	std::vector<size_t> shader_module_tasks;
+
+	std::vector<size_t> pipeline_layout_tasks;
+
+	std::vector<size_t> render_pass_tasks;
+
+	std::vector<size_t> graphics_pipeline_tasks;
+
+	std::vector<size_t> compute_pipeline_tasks;
+
+	std::vector<size_t> descriptor_set_layout_tasks;
+
+	/// Created resources, written by the task creating them
 	std::vector<ShaderModule *> shader_modules;
 
 	std::vector<PipelineLayout *> pipeline_layouts;
@@ -54,5 +106,9 @@ class ResourceReplay
 	std::vector<const RenderPass *> render_passes;
 
 	std::vector<const GraphicsPipeline *> graphics_pipelines;
+
+	std::vector<const ComputePipeline *> compute_pipelines;
+
+	std::vector<const DescriptorSetLayout *> descriptor_set_layouts;
 };
 }        // namespace vkb
@@ -0,0 +1,191 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "shader_watcher.h"
+
+#if defined(__linux__)
+#	include <dirent.h>
+#	include <poll.h>
+#	include <sys/inotify.h>
+#	include <unistd.h>
+#endif
+
+#include "common/logging.h"
+#include "core/shader_module.h"
+#include "platform/filesystem.h"
+#include "resource_cache.h"
+
+namespace vkb
+{
+namespace
+{
+/// Time without further changes before the changed files are rebuilt, as editors may write a file several times
+constexpr int QUIET_PERIOD_MS = 100;
+}        // namespace
+
+ShaderWatcher::ShaderWatcher(ResourceCache &resource_cache) :
+    resource_cache{resource_cache}
+{
+#if defined(__linux__)
+	inotify_fd = inotify_init1(IN_CLOEXEC);
+
+	if (inotify_fd < 0)
+	{
+		LOGW("Failed to initialize inotify, shader hot reload is disabled");
+		return;
+	}
+
+	watch_directory(fs::path::get(fs::path::Type::Shaders), "");
+
+	running = true;
+	thread  = std::thread(&ShaderWatcher::run, this);
+
+	LOGI("Watching {} shader directories for changes", watched_directories.size());
+#else
+	LOGW("Shader hot reload is only supported on Linux");
+#endif
+}
+
+ShaderWatcher::~ShaderWatcher()
+{
+	running = false;
+
+	if (thread.joinable())
+	{
+		thread.join();
+	}
+
+#if defined(__linux__)
+	if (inotify_fd >= 0)
+	{
+		close(inotify_fd);
+	}
+#endif
+}
+
+void ShaderWatcher::apply_reloads()
+{
+	// Shaders being rebuilt are applied on a later frame
+	std::unique_lock<std::mutex> lock{reload_mutex, std::try_to_lock};
+
+	if (!lock.owns_lock())
+	{
+		return;
+	}
+
+	for (auto &source_it : pending_sources)
+	{
+		auto count = ShaderSource::reload(source_it.first, source_it.second);
+
+		LOGI("Reloaded shader \"{}\" ({} sources updated)", source_it.first, count);
+	}
+
+	pending_sources.clear();
+}
+
+void ShaderWatcher::watch_directory(const std::string &path, const std::string &relative_path)
+{
+#if defined(__linux__)
+	int watch_descriptor = inotify_add_watch(inotify_fd, path.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+	if (watch_descriptor < 0)
+	{
+		LOGW("Failed to watch shader directory \"{}\"", path);
+		return;
+	}
+
+	watched_directories[watch_descriptor] = relative_path;
+
+	DIR *dir = opendir(path.c_str());
+
+	if (!dir)
+	{
+		return;
+	}
+
+	while (auto entry = readdir(dir))
+	{
+		std::string name{entry->d_name};
+
+		if (name == "." || name == ".." || !fs::is_directory(path + name))
+		{
+			continue;
+		}
+
+		watch_directory(path + name + "/", relative_path + name + "/");
+	}
+
+	closedir(dir);
+#endif
+}
+
+void ShaderWatcher::run()
+{
+#if defined(__linux__)
+	std::set<std::string> changed_files;
+
+	alignas(inotify_event) char buffer[4096];
+
+	while (running)
+	{
+		pollfd poll_fd{inotify_fd, POLLIN, 0};
+
+		if (poll(&poll_fd, 1, QUIET_PERIOD_MS) > 0)
+		{
+			auto length = read(inotify_fd, buffer, sizeof(buffer));
+
+			for (ssize_t offset = 0; offset < length;)
+			{
+				auto event = reinterpret_cast<const inotify_event *>(buffer + offset);
+
+				auto directory_it = watched_directories.find(event->wd);
+
+				if (event->len > 0 && !(event->mask & IN_ISDIR) && directory_it != watched_directories.end())
+				{
+					changed_files.insert(directory_it->second + event->name);
+				}
+
+				offset += sizeof(inotify_event) + event->len;
+			}
+		}
+		else if (!changed_files.empty())
+		{
+			rebuild(changed_files);
+			changed_files.clear();
+		}
+	}
+#endif
+}
+
+void ShaderWatcher::rebuild(const std::set<std::string> &changed_files)
+{
+	std::lock_guard<std::mutex> guard{reload_mutex};
+
+	try
+	{
+		// Keep the latest version of each file as plain strings, which ShaderSource::reload leaves untouched
+		for (auto &new_source : resource_cache.rebuild_shader_modules(changed_files))
+		{
+			pending_sources[new_source.get_filename()] = new_source.get_source();
+		}
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("Failed to rebuild the changed shaders: {}", e.what());
+	}
+}
+}        // namespace vkb
@@ -0,0 +1,92 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <unordered_map>
+
+namespace vkb
+{
+class ResourceCache;
+
+/**
+ * @brief Watches the shader directory to hot-reload the shaders edited while the application runs.
+ * Changed files are matched against the source files of the cached shader modules and the files they include.
+ * A background thread recompiles the affected shader modules and rebuilds the pipelines using them,
+ * then apply_reloads swaps the shader sources between frames, so that the next frame finds the new pipelines.
+ * Shaders failing to compile are logged and their previous version stays in use.
+ * Only supported on Linux, where changes are reported by inotify.
+ */
+class ShaderWatcher
+{
+  public:
+	ShaderWatcher(ResourceCache &resource_cache);
+
+	ShaderWatcher(const ShaderWatcher &) = delete;
+
+	ShaderWatcher(ShaderWatcher &&) = delete;
+
+	~ShaderWatcher();
+
+	ShaderWatcher &operator=(const ShaderWatcher &) = delete;
+
+	ShaderWatcher &operator=(ShaderWatcher &&) = delete;
+
+	/**
+	 * @brief Swaps in the sources of the rebuilt shaders
+	 *        Must be called between frames, while no other thread uses the shader sources
+	 */
+	void apply_reloads();
+
+  private:
+	/**
+	 * @brief Watches a directory and its subdirectories
+	 * @param path The absolute path of the directory
+	 * @param relative_path The path of the directory relative to the shader directory
+	 */
+	void watch_directory(const std::string &path, const std::string &relative_path);
+
+	/// @brief Waits for changes on the background thread until the watcher is destroyed
+	void run();
+
+	/// @brief Rebuilds the shaders affected by the changed files, relative to the shader directory
+	void rebuild(const std::set<std::string> &changed_files);
+
+	ResourceCache &resource_cache;
+
+	int inotify_fd{-1};
+
+	/// Path relative to the shader directory of each watched directory
+	std::unordered_map<int, std::string> watched_directories;
+
+	std::thread thread;
+
+	std::atomic<bool> running{false};
+
+	/// Held while shaders are rebuilt, so that their sources are not swapped at the same time
+	std::mutex reload_mutex;
+
+	/// New source of each rebuilt shader file, guarded by reload_mutex
+	std::map<std::string, std::string> pending_sources;
+};
+}        // namespace vkb
@@ -0,0 +1,328 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "spirv_cache.h"
+
+#include <atomic>
+#include <cstdio>
+#include <iomanip>
+#include <mutex>
+#include <random>
+#include <thread>
+
+#include "common/helpers.h"
+#include "common/logging.h"
+#include "platform/filesystem.h"
+
+namespace vkb
+{
+namespace
+{
+const uint32_t SPIRV_CACHE_MAGIC = 0x53505643;        // "SPVC"
+
+/// Version of the entry format, entries of other versions are ignored.
+/// Needs to be bumped when the layout of ShaderResource changes.
+const uint32_t SPIRV_CACHE_VERSION = 3;
+
+/// Directory of the precompiled entries, relative to the shader directory
+const char *PRECOMPILED_DIRECTORY = "spirv/";
+
+std::atomic<bool> spirv_cache_enabled{true};
+
+std::mutex spirv_cache_directory_mutex;
+
+/// Directory entries are written to, the ShaderCache path if empty
+std::string spirv_cache_directory;
+
+/**
+ * @brief FNV-1a hash, stable across platforms and standard libraries,
+ *        so that entries compiled offline on a host are found on the target
+ */
+uint64_t get_checksum(const char *data, size_t size, uint64_t checksum = 14695981039346656037ULL)
+{
+	for (size_t i = 0; i < size; ++i)
+	{
+		checksum ^= static_cast<uint8_t>(data[i]);
+		checksum *= 1099511628211ULL;
+	}
+
+	return checksum;
+}
+
+std::string get_entry_file_name(const std::string &key, const std::string &extension)
+{
+	std::ostringstream file_name;
+	file_name << std::hex << std::setw(16) << std::setfill('0') << get_checksum(key.data(), key.size()) << extension;
+
+	return file_name.str();
+}
+
+/**
+ * @brief Second hash of the key stored in the entry, to detect collisions of the file names
+ */
+uint64_t get_key_checksum(const std::string &key)
+{
+	return get_checksum(key.data(), key.size(), key.size());
+}
+
+std::string get_cache_directory()
+{
+	{
+		std::lock_guard<std::mutex> guard(spirv_cache_directory_mutex);
+
+		if (!spirv_cache_directory.empty())
+		{
+			return spirv_cache_directory;
+		}
+	}
+
+	return fs::path::get(fs::path::Type::ShaderCache);
+}
+
+bool parse_entry(const std::string &data, const std::string &key, std::string &payload)
+{
+	std::istringstream is{data};
+
+	uint32_t magic{0};
+	uint32_t version{0};
+	uint32_t size_type_size{0};
+	uint64_t key_size{0};
+	uint64_t key_checksum{0};
+	uint64_t payload_checksum{0};
+
+	read(is, magic, version, size_type_size, key_size, key_checksum, payload_checksum);
+
+	// Entries written by a platform with another size_t width are not readable
+	if (!is || magic != SPIRV_CACHE_MAGIC || version != SPIRV_CACHE_VERSION || size_type_size != sizeof(std::size_t) ||
+	    key_size != key.size() || key_checksum != get_key_checksum(key))
+	{
+		return false;
+	}
+
+	auto entry_payload = data.substr(static_cast<size_t>(is.tellg()));
+
+	if (payload_checksum != get_checksum(entry_payload.data(), entry_payload.size()))
+	{
+		LOGW("Ignoring corrupted shader cache entry");
+		return false;
+	}
+
+	payload = std::move(entry_payload);
+
+	return true;
+}
+
+/**
+ * @brief Reads the payload of an entry from the cache directory, or from the precompiled entries
+ *        shipped with the shaders, after checking that it was stored for the key
+ */
+bool load_entry(const std::string &key, const std::string &extension, std::string &payload)
+{
+	if (!spirv_cache_enabled)
+	{
+		return false;
+	}
+
+	auto file_name = get_entry_file_name(key, extension);
+
+	std::ifstream file(get_cache_directory() + file_name, std::ios::in | std::ios::binary);
+
+	if (file.is_open())
+	{
+		if (parse_entry(std::string{std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>()}, key, payload))
+		{
+			return true;
+		}
+	}
+
+	auto precompiled_path = std::string{PRECOMPILED_DIRECTORY} + file_name;
+
+	if (!fs::is_file(fs::path::get(fs::path::Type::Shaders) + precompiled_path))
+	{
+		return false;
+	}
+
+	auto data = fs::read_shader_binary(precompiled_path);
+
+	return parse_entry(std::string{data.begin(), data.end()}, key, payload);
+}
+
+/**
+ * @brief Writes an entry to a temporary file unique to this thread and process, then renames it over the entry
+ */
+void store_entry(const std::string &key, const std::string &extension, const std::string &payload)
+{
+	if (!spirv_cache_enabled)
+	{
+		return;
+	}
+
+	std::ostringstream os;
+	write(os,
+	      SPIRV_CACHE_MAGIC,
+	      SPIRV_CACHE_VERSION,
+	      static_cast<uint32_t>(sizeof(std::size_t)),
+	      static_cast<uint64_t>(key.size()),
+	      get_key_checksum(key),
+	      get_checksum(payload.data(), payload.size()));
+	os.write(payload.data(), payload.size());
+
+	auto entry_path = get_cache_directory() + get_entry_file_name(key, extension);
+
+	std::ostringstream temp_path;
+	temp_path << entry_path << "." << std::hex << std::hash<std::thread::id>{}(std::this_thread::get_id()) << std::random_device{}() << ".tmp";
+
+	{
+		std::ofstream file(temp_path.str(), std::ios::out | std::ios::binary | std::ios::trunc);
+
+		auto data = os.str();
+		file.write(data.data(), data.size());
+
+		if (!file)
+		{
+			LOGW("Failed to write shader cache entry {}", temp_path.str());
+			file.close();
+			std::remove(temp_path.str().c_str());
+			return;
+		}
+	}
+
+	if (std::rename(temp_path.str().c_str(), entry_path.c_str()) != 0)
+	{
+		// Another process may have stored the same entry first
+		std::remove(temp_path.str().c_str());
+	}
+}
+}        // namespace
+
+void SPIRVCache::set_enabled(bool enabled)
+{
+	spirv_cache_enabled = enabled;
+}
+
+void SPIRVCache::set_directory(const std::string &directory)
+{
+	std::lock_guard<std::mutex> guard(spirv_cache_directory_mutex);
+
+	spirv_cache_directory = directory;
+}
+
+bool SPIRVCache::is_enabled()
+{
+	return spirv_cache_enabled;
+}
+
+bool SPIRVCache::load(const std::string &key, std::vector<uint32_t> &spirv)
+{
+	std::string payload;
+
+	if (!load_entry(key, ".spv", payload) || payload.size() % sizeof(uint32_t) != 0)
+	{
+		return false;
+	}
+
+	spirv.resize(payload.size() / sizeof(uint32_t));
+	std::copy(payload.begin(), payload.end(), reinterpret_cast<char *>(spirv.data()));
+
+	return true;
+}
+
+void SPIRVCache::store(const std::string &key, const std::vector<uint32_t> &spirv)
+{
+	store_entry(key, ".spv", std::string{reinterpret_cast<const char *>(spirv.data()), spirv.size() * sizeof(uint32_t)});
+}
+
+bool SPIRVCache::load_reflection(const std::string &key, std::vector<ShaderResource> &resources)
+{
+	std::string payload;
+
+	if (!load_entry(key, ".refl", payload))
+	{
+		return false;
+	}
+
+	std::istringstream is{payload};
+
+	std::size_t resource_count{0};
+	read(is, resource_count);
+
+	// Each resource takes at least the size of its fixed fields
+	if (!is || resource_count > payload.size() / (sizeof(uint32_t) * 12))
+	{
+		return false;
+	}
+
+	std::vector<ShaderResource> data(resource_count);
+
+	for (auto &resource : data)
+	{
+		read(is,
+		     resource.stages,
+		     resource.type,
+		     resource.mode,
+		     resource.set,
+		     resource.binding,
+		     resource.location,
+		     resource.input_attachment_index,
+		     resource.vec_size,
+		     resource.columns,
+		     resource.array_size,
+		     resource.offset,
+		     resource.size,
+		     resource.constant_id,
+		     resource.qualifiers,
+		     resource.name);
+	}
+
+	if (!is)
+	{
+		return false;
+	}
+
+	resources = std::move(data);
+
+	return true;
+}
+
+void SPIRVCache::store_reflection(const std::string &key, const std::vector<ShaderResource> &resources)
+{
+	std::ostringstream os;
+	write(os, resources.size());
+
+	for (auto &resource : resources)
+	{
+		write(os,
+		      resource.stages,
+		      resource.type,
+		      resource.mode,
+		      resource.set,
+		      resource.binding,
+		      resource.location,
+		      resource.input_attachment_index,
+		      resource.vec_size,
+		      resource.columns,
+		      resource.array_size,
+		      resource.offset,
+		      resource.size,
+		      resource.constant_id,
+		      resource.qualifiers,
+		      resource.name);
+	}
+
+	store_entry(key, ".refl", os.str());
+}
+}        // namespace vkb
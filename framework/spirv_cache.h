@@ -0,0 +1,81 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "core/shader_module.h"
+
+namespace vkb
+{
+/**
+ * @brief Content addressed on-disk cache of the SPIR-V generated from GLSL and of the resources
+ *        reflected from SPIR-V, shared across runs.
+ *        Entries are written to a temporary file which is then renamed over the entry,
+ *        so several processes can share the cache without reading partially written entries.
+ *        Entries missing from the cache directory are looked up in the spirv/ folder of the shaders,
+ *        where the offline_shaders build target writes the precompiled ones.
+ */
+class SPIRVCache
+{
+  public:
+	/**
+	 * @brief Enables or disables the cache for the whole application, it is enabled by default
+	 */
+	static void set_enabled(bool enabled);
+
+	static bool is_enabled();
+
+	/**
+	 * @brief Sets the directory entries are written to and looked up first
+	 * @param directory Path ending with a separator, or empty for the ShaderCache directory
+	 */
+	static void set_directory(const std::string &directory);
+
+	/**
+	 * @brief Loads the SPIR-V stored for a key
+	 * @param key Key covering every input of the compilation
+	 * @param[out] spirv The cached SPIR-V code
+	 * @return False if the cache is disabled, the entry does not exist or is not valid
+	 */
+	static bool load(const std::string &key, std::vector<uint32_t> &spirv);
+
+	/**
+	 * @brief Stores the SPIR-V compiled for a key, failures are only logged
+	 * @param key Key covering every input of the compilation
+	 * @param spirv The compiled SPIR-V code
+	 */
+	static void store(const std::string &key, const std::vector<uint32_t> &spirv);
+
+	/**
+	 * @brief Loads the shader resources reflected for a key
+	 * @param key Key covering the SPIR-V code and every reflection parameter
+	 * @param[out] resources The cached shader resources
+	 * @return False if the cache is disabled, the entry does not exist or is not valid
+	 */
+	static bool load_reflection(const std::string &key, std::vector<ShaderResource> &resources);
+
+	/**
+	 * @brief Stores the shader resources reflected for a key, failures are only logged
+	 * @param key Key covering the SPIR-V code and every reflection parameter
+	 * @param resources The reflected shader resources
+	 */
+	static void store_reflection(const std::string &key, const std::vector<ShaderResource> &resources);
+};
+}        // namespace vkb
@@ -17,6 +17,8 @@
 
 #include "spirv_reflection.h"
 
+#include "spirv_cache.h"
+
 namespace vkb
 {
 namespace
@@ -374,6 +376,29 @@ inline void read_shader_resource<ShaderResourceType::BufferStorage>(const spirv_
 
 bool SPIRVReflection::reflect_shader_resources(VkShaderStageFlagBits stage, const std::vector<uint32_t> &spirv, std::vector<ShaderResource> &resources, const ShaderVariant &variant)
 {
+	// The reflection depends on the code, the stage and the sizes of the runtime arrays
+	std::map<std::string, size_t> runtime_array_sizes{variant.get_runtime_array_sizes().begin(), variant.get_runtime_array_sizes().end()};
+
+	std::ostringstream cache_key;
+	write(cache_key, stage, runtime_array_sizes.size());
+
+	for (auto &runtime_array_size : runtime_array_sizes)
+	{
+		write(cache_key, runtime_array_size.first, runtime_array_size.second);
+	}
+
+	cache_key.write(reinterpret_cast<const char *>(spirv.data()), spirv.size() * sizeof(uint32_t));
+
+	std::vector<ShaderResource> cached_resources;
+
+	if (SPIRVCache::load_reflection(cache_key.str(), cached_resources))
+	{
+		resources.insert(resources.end(), cached_resources.begin(), cached_resources.end());
+		return true;
+	}
+
+	auto first_resource = resources.size();
+
 	spirv_cross::CompilerGLSL compiler{spirv};
 
 	auto opts                     = compiler.get_common_options();
@@ -385,6 +410,8 @@ bool SPIRVReflection::reflect_shader_resources(VkShaderStageFlagBits stage, cons
 	parse_push_constants(compiler, stage, resources, variant);
 	parse_specialization_constants(compiler, stage, resources, variant);
 
+	SPIRVCache::store_reflection(cache_key.str(), std::vector<ShaderResource>{resources.begin() + first_resource, resources.end()});
+
 	return true;
 }
 
@@ -0,0 +1,73 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "command_buffer_stats_provider.h"
+
+#include "core/command_buffer.h"
+
+namespace vkb
+{
+namespace
+{
+const std::set<StatIndex> command_buffer_stats{
+    StatIndex::state_commands_emitted,
+    StatIndex::state_commands_filtered,
+};
+}        // namespace
+
+CommandBufferStatsProvider::CommandBufferStatsProvider(std::set<StatIndex> &requested_stats)
+{
+	for (auto index : command_buffer_stats)
+	{
+		// Remove from requested set to stop other providers looking for it
+		if (requested_stats.erase(index))
+		{
+			stat_indices.insert(index);
+		}
+	}
+}
+
+bool CommandBufferStatsProvider::is_available(StatIndex index) const
+{
+	return stat_indices.find(index) != stat_indices.end();
+}
+
+StatsProvider::Counters CommandBufferStatsProvider::sample(float /*delta_time*/)
+{
+	Counters res;
+
+	if (stat_indices.empty())
+	{
+		return res;
+	}
+
+	// Counts of the command buffers ended since the previous sample
+	auto counts = CommandBuffer::reset_state_command_counts();
+
+	if (is_available(StatIndex::state_commands_emitted))
+	{
+		res[StatIndex::state_commands_emitted].result = static_cast<double>(counts.emitted);
+	}
+
+	if (is_available(StatIndex::state_commands_filtered))
+	{
+		res[StatIndex::state_commands_filtered].result = static_cast<double>(counts.filtered);
+	}
+
+	return res;
+}
+}        // namespace vkb
@@ -0,0 +1,123 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "resource_cache_stats_provider.h"
+
+#include "core/device.h"
+#include "rendering/render_context.h"
+
+namespace vkb
+{
+namespace
+{
+const std::set<StatIndex> resource_cache_stats{
+    StatIndex::pipeline_compiles_pending,
+    StatIndex::pipeline_compiles_ready,
+    StatIndex::resource_cache_evictions,
+    StatIndex::resource_cache_hits,
+    StatIndex::resource_cache_misses,
+    StatIndex::resource_cache_objects,
+    StatIndex::pipeline_creation_time,
+};
+}        // namespace
+
+ResourceCacheStatsProvider::ResourceCacheStatsProvider(std::set<StatIndex> &requested_stats, RenderContext &render_context) :
+    render_context{render_context}
+{
+	for (auto index : resource_cache_stats)
+	{
+		// Remove from requested set to stop other providers looking for it
+		if (requested_stats.erase(index))
+		{
+			stat_indices.insert(index);
+		}
+	}
+}
+
+bool ResourceCacheStatsProvider::is_available(StatIndex index) const
+{
+	return stat_indices.find(index) != stat_indices.end();
+}
+
+StatsProvider::Counters ResourceCacheStatsProvider::sample(float /*delta_time*/)
+{
+	Counters res;
+
+	auto &resource_cache = render_context.get_device().get_resource_cache();
+
+	if (is_available(StatIndex::pipeline_compiles_pending))
+	{
+		res[StatIndex::pipeline_compiles_pending].result = resource_cache.get_pending_pipeline_count();
+	}
+
+	if (is_available(StatIndex::pipeline_compiles_ready))
+	{
+		res[StatIndex::pipeline_compiles_ready].result = resource_cache.reset_ready_pipeline_count();
+	}
+
+	if (is_available(StatIndex::resource_cache_evictions))
+	{
+		res[StatIndex::resource_cache_evictions].result = resource_cache.reset_evicted_count();
+	}
+
+	uint64_t hits{0};
+	uint64_t misses{0};
+	size_t   live_count{0};
+	double   pipeline_creation_time{0.0};
+
+	for (size_t i = 0; i < static_cast<size_t>(ResourceCacheType::Count); ++i)
+	{
+		auto type  = static_cast<ResourceCacheType>(i);
+		auto stats = resource_cache.get_stats(type);
+
+		hits += stats.hits;
+		misses += stats.misses;
+		live_count += stats.live_count;
+
+		if (type == ResourceCacheType::GraphicsPipeline || type == ResourceCacheType::ComputePipeline)
+		{
+			pipeline_creation_time += stats.creation_time;
+		}
+	}
+
+	if (is_available(StatIndex::resource_cache_hits))
+	{
+		res[StatIndex::resource_cache_hits].result = static_cast<double>(hits - previous_hits);
+	}
+
+	if (is_available(StatIndex::resource_cache_misses))
+	{
+		res[StatIndex::resource_cache_misses].result = static_cast<double>(misses - previous_misses);
+	}
+
+	if (is_available(StatIndex::resource_cache_objects))
+	{
+		res[StatIndex::resource_cache_objects].result = static_cast<double>(live_count);
+	}
+
+	if (is_available(StatIndex::pipeline_creation_time))
+	{
+		res[StatIndex::pipeline_creation_time].result = pipeline_creation_time - previous_pipeline_creation_time;
+	}
+
+	previous_hits                   = hits;
+	previous_misses                 = misses;
+	previous_pipeline_creation_time = pipeline_creation_time;
+
+	return res;
+}
+}        // namespace vkb
@@ -20,8 +20,10 @@
 #include "common/error.h"
 #include "core/device.h"
 
+#include "command_buffer_stats_provider.h"
 #include "frame_time_stats_provider.h"
 #include "hwcpipe_stats_provider.h"
+#include "resource_cache_stats_provider.h"
 #include "vulkan_stats_provider.h"
 
 namespace vkb
@@ -66,6 +68,8 @@ void Stats::request_stats(const std::set<StatIndex> &wanted_stats,
 	providers.emplace_back(std::make_unique<FrameTimeStatsProvider>(stats));
 	providers.emplace_back(std::make_unique<HWCPipeStatsProvider>(stats));
 	providers.emplace_back(std::make_unique<VulkanStatsProvider>(stats, sampling_config, render_context));
+	providers.emplace_back(std::make_unique<ResourceCacheStatsProvider>(stats, render_context));
+	providers.emplace_back(std::make_unique<CommandBufferStatsProvider>(stats));
 
 	// In continuous sampling mode we still need to update the frame times as if we are polling
 	// Store the frame time provider here so we can easily access it later.
@@ -63,6 +63,16 @@ enum class StatIndex
 	gpu_ext_read_bytes,
 	gpu_ext_write_bytes,
 	gpu_tex_cycles,
+
+	pipeline_compiles_pending,
+	pipeline_compiles_ready,
+	resource_cache_evictions,
+	resource_cache_hits,
+	resource_cache_misses,
+	resource_cache_objects,
+	pipeline_creation_time,
+	state_commands_emitted,
+	state_commands_filtered,
 };
 
 struct StatIndexHash
@@ -54,6 +54,16 @@ std::map<StatIndex, StatGraphData> StatsProvider::default_graph_map{
     {StatIndex::gpu_ext_write_stalls,  {"External Write Stalls",                       "{:4.1f} M/s",   float(1e-6)}},
     {StatIndex::gpu_ext_read_bytes,    {"External Read Bytes",                         "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
     {StatIndex::gpu_ext_write_bytes,   {"External Write Bytes",                        "{:4.1f} MiB/s", 1.0f / (1024.0f * 1024.0f)}},
+
+    {StatIndex::pipeline_compiles_pending, {"Pending Pipeline Compiles",               "{:4.0f}"}},
+    {StatIndex::pipeline_compiles_ready,   {"Ready Pipeline Compiles",                 "{:4.0f}"}},
+    {StatIndex::resource_cache_evictions,  {"Cache Evictions",                         "{:4.0f}"}},
+    {StatIndex::resource_cache_hits,       {"Cache Hits",                              "{:4.0f}"}},
+    {StatIndex::resource_cache_misses,     {"Cache Misses",                            "{:4.0f}"}},
+    {StatIndex::resource_cache_objects,    {"Cached Objects",                          "{:4.0f}"}},
+    {StatIndex::pipeline_creation_time,    {"Pipeline Creation Time",                  "{:3.1f} ms"}},
+    {StatIndex::state_commands_emitted,    {"Emitted State Commands",                  "{:4.0f}"}},
+    {StatIndex::state_commands_filtered,   {"Filtered State Commands",                 "{:4.0f}"}},
     // clang-format on
 };
 
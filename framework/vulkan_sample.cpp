@@ -31,6 +31,7 @@ VKBP_ENABLE_WARNINGS()
 #include "common/utils.h"
 #include "common/vk_common.h"
 #include "gltf_loader.h"
+#include "platform/filesystem.h"
 #include "platform/platform.h"
 #include "platform/window.h"
 #include "scene_graph/components/camera.h"
@@ -46,9 +47,18 @@ namespace vkb
 {
 VulkanSample::~VulkanSample()
 {
+	shader_watcher.reset();
+
 	if (device)
 	{
 		device->wait_idle();
+
+		if (resource_pipeline_cache != VK_NULL_HANDLE)
+		{
+			save_resource_cache();
+
+			vkDestroyPipelineCache(device->get_handle(), resource_pipeline_cache, nullptr);
+		}
 	}
 
 	scene.reset();
@@ -69,6 +79,18 @@ VulkanSample::~VulkanSample()
 void VulkanSample::set_render_pipeline(RenderPipeline &&rp)
 {
 	render_pipeline = std::make_unique<RenderPipeline>(std::move(rp));
+
+	if (pipeline_prewarm)
+	{
+		try
+		{
+			render_pipeline->prewarm(render_context->get_render_frames().front()->get_render_target());
+		}
+		catch (std::exception &ex)
+		{
+			LOGW("Failed to prewarm render pipeline: {}", ex.what());
+		}
+	}
 }
 
 RenderPipeline &VulkanSample::get_render_pipeline()
@@ -113,6 +135,16 @@ bool VulkanSample::prepare(Platform &platform)
 
 	device = std::make_unique<vkb::Device>(gpu, surface, get_device_extensions());
 
+	if (persistent_resource_cache)
+	{
+		load_resource_cache();
+	}
+
+	if (shader_hot_reload)
+	{
+		shader_watcher = std::make_unique<ShaderWatcher>(device->get_resource_cache());
+	}
+
 	create_render_context(platform);
 	prepare_render_context();
 
@@ -121,6 +153,72 @@ bool VulkanSample::prepare(Platform &platform)
 	return true;
 }
 
+void VulkanSample::load_resource_cache()
+{
+	auto &resource_cache = device->get_resource_cache();
+
+	std::vector<uint8_t> pipeline_cache_data;
+	std::vector<uint8_t> resource_data;
+
+	try
+	{
+		auto file_data = fs::read_storage(get_name() + "_resource_cache.data");
+
+		if (!resource_cache.deserialize_warmup_file(file_data, pipeline_cache_data, resource_data))
+		{
+			LOGW("Discarding stale resource cache file");
+		}
+	}
+	catch (std::runtime_error &ex)
+	{
+		LOGI("No resource cache file found, resources will be built on first use. {}", ex.what());
+	}
+
+	VkPipelineCacheCreateInfo create_info{VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO};
+	create_info.initialDataSize = pipeline_cache_data.size();
+	create_info.pInitialData    = pipeline_cache_data.data();
+
+	VK_CHECK(vkCreatePipelineCache(device->get_handle(), &create_info, nullptr, &resource_pipeline_cache));
+
+	resource_cache.set_pipeline_cache(resource_pipeline_cache);
+
+	if (resource_data.empty())
+	{
+		return;
+	}
+
+	Timer timer;
+	timer.start();
+
+	try
+	{
+		resource_cache.warmup(resource_data);
+	}
+	catch (std::exception &ex)
+	{
+		LOGW("Failed to warm up resource cache: {}", ex.what());
+	}
+
+	auto elapsed_time = timer.stop<Timer::Milliseconds>();
+
+	const auto &state = resource_cache.get_internal_state();
+
+	LOGI("Resource cache warmup built {} graphics pipelines from {} shader modules in {} ms",
+	     state.graphics_pipelines.size(), state.shader_modules.size(), vkb::to_string(elapsed_time));
+}
+
+void VulkanSample::save_resource_cache()
+{
+	try
+	{
+		fs::write_storage(device->get_resource_cache().serialize_warmup_file(), get_name() + "_resource_cache.data");
+	}
+	catch (std::exception &ex)
+	{
+		LOGW("Failed to save resource cache: {}", ex.what());
+	}
+}
+
 void VulkanSample::create_render_context(Platform &platform)
 {
 	auto surface_priority_list = std::vector<VkSurfaceFormatKHR>{{VK_FORMAT_R8G8B8A8_SRGB, VK_COLOR_SPACE_SRGB_NONLINEAR_KHR},
@@ -204,6 +302,12 @@ void VulkanSample::update_gui(float delta_time)
 
 void VulkanSample::update(float delta_time)
 {
+	// Swap in the shaders rebuilt since the last frame, before any of them is used
+	if (shader_watcher)
+	{
+		shader_watcher->apply_reloads();
+	}
+
 	update_scene(delta_time);
 
 	update_gui(delta_time);
@@ -28,6 +28,7 @@
 #include "scene_graph/node.h"
 #include "scene_graph/scene.h"
 #include "scene_graph/scripts/node_animation.h"
+#include "shader_watcher.h"
 #include "stats/stats.h"
 
 namespace vkb
@@ -313,6 +314,50 @@ class VulkanSample : public Application
 		high_priority_graphics_queue = enable;
 	}
 
+	/**
+	 * @brief Sets whether the resource cache is warmed up from a file in storage and saved back on exit.
+	 * Needs to be called before prepare().
+	 * @param enable If true, the pipeline cache and the recorded resources are persisted across runs.
+	 * Default state is true.
+	 */
+	void set_persistent_resource_cache_enable(bool enable)
+	{
+		persistent_resource_cache = enable;
+	}
+
+	/**
+	 * @brief Sets whether set_render_pipeline() creates up front the pipelines of the render pipeline
+	 *        for the render target of the render context, instead of on first draw.
+	 * @param enable If true, the render pipeline is prewarmed when it is set.
+	 * Default state is false.
+	 */
+	void set_pipeline_prewarm_enable(bool enable)
+	{
+		pipeline_prewarm = enable;
+	}
+
+	/**
+	 * @brief Sets whether the shaders edited while the sample runs are recompiled and swapped in between frames.
+	 *        Must be set before prepare(), only supported on Linux.
+	 * @param enable If true, the shader directory is watched for changes.
+	 * Default state is false.
+	 */
+	void set_shader_hot_reload_enable(bool enable)
+	{
+		shader_hot_reload = enable;
+	}
+
+	/**
+	 * @brief Creates the pipeline cache of the resource cache, and warms both up from the
+	 *        warmup file of the sample if it exists and matches the current device and driver
+	 */
+	void load_resource_cache();
+
+	/**
+	 * @brief Writes the pipeline cache and the recorded resources to the warmup file of the sample
+	 */
+	void save_resource_cache();
+
   private:
 	/** @brief Set of device extensions to be enabled for this example and wether they are optional (must be set in the derived constructor) */
 	std::unordered_map<const char *, bool> device_extensions;
@@ -325,5 +370,20 @@ class VulkanSample : public Application
 
 	/** @brief Whether or not we want a high priority graphics queue. */
 	bool high_priority_graphics_queue{false};
+
+	/** @brief Whether or not the resource cache is persisted across runs. */
+	bool persistent_resource_cache{true};
+
+	/** @brief Whether or not the render pipeline is prewarmed when it is set. */
+	bool pipeline_prewarm{false};
+
+	/** @brief Whether or not the shaders are hot-reloaded when edited. */
+	bool shader_hot_reload{false};
+
+	/** @brief Watches the shader files when shader hot reload is enabled */
+	std::unique_ptr<ShaderWatcher> shader_watcher{nullptr};
+
+	/** @brief Pipeline cache used by the resource cache when it is persisted */
+	VkPipelineCache resource_pipeline_cache{VK_NULL_HANDLE};
 };
 }        // namespace vkb
@@ -34,6 +34,9 @@ PipelineCache::PipelineCache()
 
 	config.insert<vkb::BoolSetting>(0, enable_pipeline_cache, true);
 	config.insert<vkb::BoolSetting>(1, enable_pipeline_cache, false);
+
+	// This sample manages its own pipeline cache and warmup data
+	set_persistent_resource_cache_enable(false);
 }
 
 PipelineCache::~PipelineCache()
@@ -0,0 +1,205 @@
+/* Copyright (c) 2021, Arm Limited and Contributors
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 the "License";
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <cstdlib>
+
+#include "common/logging.h"
+#include "common/strings.h"
+#include "common/utils.h"
+#include "core/shader_module.h"
+#include "glsl_compiler.h"
+#include "platform/filesystem.h"
+#include "platform/platform.h"
+#include "spirv_cache.h"
+#include "spirv_reflection.h"
+
+namespace
+{
+VkShaderStageFlagBits find_shader_stage(const std::string &ext)
+{
+	static const std::unordered_map<std::string, VkShaderStageFlagBits> stages = {
+	    {"vert", VK_SHADER_STAGE_VERTEX_BIT},
+	    {"frag", VK_SHADER_STAGE_FRAGMENT_BIT},
+	    {"comp", VK_SHADER_STAGE_COMPUTE_BIT},
+	    {"geom", VK_SHADER_STAGE_GEOMETRY_BIT},
+	    {"tesc", VK_SHADER_STAGE_TESSELLATION_CONTROL_BIT},
+	    {"tese", VK_SHADER_STAGE_TESSELLATION_EVALUATION_BIT},
+	    {"rgen", VK_SHADER_STAGE_RAYGEN_BIT_KHR},
+	    {"rahit", VK_SHADER_STAGE_ANY_HIT_BIT_KHR},
+	    {"rchit", VK_SHADER_STAGE_CLOSEST_HIT_BIT_KHR},
+	    {"rmiss", VK_SHADER_STAGE_MISS_BIT_KHR},
+	    {"rint", VK_SHADER_STAGE_INTERSECTION_BIT_KHR},
+	    {"rcall", VK_SHADER_STAGE_CALLABLE_BIT_KHR}};
+
+	auto it = stages.find(ext);
+
+	if (it == stages.end())
+	{
+		throw std::runtime_error("File extension `" + ext + "` does not have a vulkan shader stage.");
+	}
+
+	return it->second;
+}
+
+/**
+ * @brief Reads the variants a sample declares for a shader in a <shader>.variants file.
+ *        Each line is a variant, listing the definitions added to it separated by ';',
+ *        in the order the sample adds them. Lines starting with '#' are ignored.
+ * @return The default variant followed by the declared ones
+ */
+std::vector<vkb::ShaderVariant> read_shader_variants(const std::string &filename)
+{
+	std::vector<vkb::ShaderVariant> variants(1);
+
+	auto variants_file = filename + ".variants";
+
+	if (!vkb::fs::is_file(vkb::fs::path::get(vkb::fs::path::Type::Shaders) + variants_file))
+	{
+		return variants;
+	}
+
+	for (auto &line : vkb::split(vkb::fs::read_shader(variants_file), '\n'))
+	{
+		if (!line.empty() && line.back() == '\r')
+		{
+			line.pop_back();
+		}
+
+		if (line.empty() || line.front() == '#')
+		{
+			continue;
+		}
+
+		vkb::ShaderVariant variant;
+
+		for (auto &definition : vkb::split(line, ';'))
+		{
+			if (!definition.empty())
+			{
+				variant.add_define(definition);
+			}
+		}
+
+		variants.push_back(std::move(variant));
+	}
+
+	return variants;
+}
+}        // namespace
+
+/**
+ * @brief Compiles shaders and their declared variants to SPIR-V entries of the SPIRVCache,
+ *        which are loaded at runtime instead of compiling the GLSL source
+ *
+ * Usage: shader_compiler <root directory> <output directory> <shader files...>
+ * The shader files are relative to the shaders folder of the root directory.
+ */
+int main(int argc, char *argv[])
+{
+	if (argc < 3)
+	{
+		LOGE("Usage: shader_compiler <root directory> <output directory> <shader files...>");
+		return EXIT_FAILURE;
+	}
+
+	// Shaders are read from the root directory as when running the samples, so includes expand identically
+	vkb::Platform::set_external_storage_directory(argv[1]);
+	vkb::SPIRVCache::set_directory(argv[2]);
+
+	std::vector<vkb::GLSLCompileJob> jobs;
+	std::vector<std::string>         job_files;
+	std::vector<bool>                job_declared;
+
+	try
+	{
+		for (int i = 3; i < argc; ++i)
+		{
+			std::string filename = argv[i];
+
+			auto stage  = find_shader_stage(vkb::get_extension(filename));
+			auto source = vkb::expand_shader_includes(vkb::fs::read_shader(filename));
+
+			auto variants = read_shader_variants(filename);
+
+			for (size_t variant_index = 0; variant_index < variants.size(); ++variant_index)
+			{
+				vkb::GLSLCompileJob job;
+				job.stage          = stage;
+				job.glsl_source    = source;
+				job.shader_variant = variants[variant_index];
+
+				jobs.push_back(std::move(job));
+				job_files.push_back(filename);
+				job_declared.push_back(variant_index != 0);
+			}
+		}
+	}
+	catch (const std::exception &e)
+	{
+		LOGE("{}", e.what());
+		return EXIT_FAILURE;
+	}
+
+	vkb::GLSLCompiler glsl_compiler;
+	glsl_compiler.compile_to_spirv(jobs);
+
+	bool success = true;
+
+	vkb::SPIRVReflection spirv_reflection;
+
+	for (size_t i = 0; i < jobs.size(); ++i)
+	{
+		auto &job = jobs[i];
+
+		if (!job.compiled)
+		{
+			// Shaders which need definitions from the sample can not compile with the default variant,
+			// they are compiled at runtime instead
+			if (job_declared[i])
+			{
+				LOGE("Failed to compile a declared variant of \"{}\":\n{}", job_files[i], job.info_log);
+				success = false;
+			}
+			else
+			{
+				LOGW("Skipping \"{}\" without definitions:\n{}", job_files[i], job.info_log);
+			}
+
+			continue;
+		}
+
+		// Store the reflected resources as well
+		std::vector<vkb::ShaderResource> resources;
+		spirv_reflection.reflect_shader_resources(job.stage, job.spirv, resources, job.shader_variant);
+	}
+
+	LOGI("Compiled {} shader variants from {} files", jobs.size(), argc - 3);
+
+	auto optimization_stats = vkb::GLSLCompiler::get_optimization_stats();
+
+	if (optimization_stats.module_count > 0)
+	{
+		LOGI("Optimized {} shaders: {} -> {} instructions, {} -> {} bytes",
+		     optimization_stats.module_count,
+		     optimization_stats.instruction_count_before,
+		     optimization_stats.instruction_count_after,
+		     optimization_stats.size_before,
+		     optimization_stats.size_after);
+	}
+
+	return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}